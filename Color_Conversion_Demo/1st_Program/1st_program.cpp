@@ -80,45 +80,35 @@ int main(int argc, char** argv) {
   merge(xyY_planes, 3, xyY);
   merge(Luv_planes, 3, Luv);
 
-  //Initialize the needed intermediate and final xyY images
-  Mat xyY2XYZ(height, width, depth2);
-  Mat xyY2lRGB(height, width, depth2);
-  Mat xyY2nRGB(height, width, depth2);
-  
+  //The float steps below run in place in the xyY and Luv images,
+  //only the final non-linear scaled RGB images need their own buffers
   //non-linear scaled RGB images are [0-255] byte (uint) images
   int depth3=CV_8UC3;
   Mat xyY2nsRGB(height, width, depth3);
   Mat xyY2nsBGR(height, width, depth3);
-
-  //Initialize the needed intermediate and final Luv images
-  Mat Luv2XYZ(height, width, depth2);
-  Mat Luv2lRGB(height, width, depth2);
-  Mat Luv2nRGB(height, width, depth2);
-  
-  //non-linear scaled RGB images are [0-255] byte (uint) images
   Mat Luv2nsRGB(height, width, depth3);
   Mat Luv2nsBGR(height, width, depth3);
 
   cout << "Starting color conversions." << endl;
 
   //Convert xyY to nonlinear scaled RGB in 4 steps
-  xyYtoXYZ(xyY,xyY2XYZ);
+  xyYtoXYZ(xyY,xyY);
   cout << "Completed xyY to XYZ conversion." << endl;
-  XYZtolRGB(xyY2XYZ,xyY2lRGB);
+  XYZtolRGB(xyY,xyY);
   cout << "Completed xyY to lRGB conversion." << endl;
-  lRGBtonRGB(xyY2lRGB,xyY2nRGB);
+  lRGBtonRGB(xyY,xyY);
   cout << "Completed xyY to nRGB conversion." << endl;
-  nRGBtonsRGB(xyY2nRGB,xyY2nsRGB);
+  nRGBtonsRGB(xyY,xyY2nsRGB);
   cout << "Completed xyY to nsRGB conversion." << endl;
 
   //Convert Luv to nonlinear scaled RGB in 4 steps
-  LuvtoXYZ(Luv,Luv2XYZ);
+  LuvtoXYZ(Luv,Luv);
   cout << "Completed LuV to XYZ conversion." << endl;
-  XYZtolRGB(Luv2XYZ,Luv2lRGB);
+  XYZtolRGB(Luv,Luv);
   cout << "Completed Luv to lRGB conversion." << endl;
-  lRGBtonRGB(Luv2lRGB,Luv2nRGB);
+  lRGBtonRGB(Luv,Luv);
   cout << "Completed Luv to nRGB conversion." << endl;
-  nRGBtonsRGB(Luv2nRGB,Luv2nsRGB);
+  nRGBtonsRGB(Luv,Luv2nsRGB);
   cout << "Completed Luv to nsRGB conversion." << endl;
 
   //Convert RGB to BGR
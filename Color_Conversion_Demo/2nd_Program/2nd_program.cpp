@@ -32,12 +32,12 @@ using namespace cv;
 using namespace std;
 
 int main(int argc, char** argv) {
-	if(argc != 7) {
+	if(argc != 7 && argc != 8) {
 	    cerr << argv[0] << ": "
 		 << "got " << argc-1
-		 << " arguments. Expecting six: w1 h1 w2 h2 ImageIn ImageOut."
+		 << " arguments. Expecting six or seven: w1 h1 w2 h2 ImageIn ImageOut [CacheDir]."
 		 << endl ;
-	    cerr << "Example: proj1b 0.2 0.1 0.8 0.5 fruits.jpg out.bmp" << endl;
+	    cerr << "Example: proj1b 0.2 0.1 0.8 0.5 fruits.jpg out.bmp cache" << endl;
 	    return(-1);
 	  }
 	  double w1 = atof(argv[1]);
@@ -47,6 +47,9 @@ int main(int argc, char** argv) {
 	  char *inputName = argv[5];
 	  char *outputName = argv[6];
 
+	  //Forward conversions are kept in the cache directory, bounded to 1 GB, and reused on later runs
+	  if(argc == 8 && !setConversionCache(argv[7], (size_t)1<<30)) return(-1);
+
 	  if(w1<0 || h1<0 || w2<=w1 || h2<=h1 || w2>1 || h2>1) {
 	    cerr << " arguments must satisfy 0 <= w1 < w2 <= 1"
 		 << " ,  0 <= h1 < h2 <= 1" << endl;
@@ -69,64 +72,41 @@ int main(int argc, char** argv) {
 	    cout <<  inputName << " is not a standard 8UC3 color image  " << endl;
 	    return(-1);
 	  }
-	  int depth1 = CV_8UC3;
-	  int depth2 = CV_32FC3;
-	  int height = inputImage.rows;
-	  int width = inputImage.cols;
-
-	  //Initialize the needed intermediate and final images
-	  Mat nsRGB(height, width, depth1);
-	  Mat nRGB(height, width, depth2);
-	  Mat lRGB(height, width, depth2);
-	  Mat XYZ(height, width, depth2);
-	  Mat Luv(height, width, depth2);
-	  Mat stretchLuv(height, width, depth2);
-	  Mat XYZ2(height, width, depth2);
-	  Mat lRGB2(height, width, depth2);
-	  Mat nRGB2(height, width, depth2);
-	  Mat outputImage(height, width, depth1);
-	  Mat outputImageBGR(height, width, depth1);
+
+	  //The conversions run in place, so one byte image and one float image
+	  //are all that is held between reading the input and writing the output
+	  Mat nsRGB = inputImage;
+	  //Luv is kept in planar form, stretching L leaves the u and v planes untouched
+	  PlanarImage Luv;
 
 	  cout << "Starting color conversions." << endl;
 
-	  //Convert input image (nsRGB) to Luv in 5 steps
-  	  cvtColor(inputImage, nsRGB, COLOR_RGB2BGR);
+	  //Convert input image (nsRGB) to Luv in 2 steps
+  	  cvtColor(nsRGB, nsRGB, COLOR_RGB2BGR);
   	  cout << "Completed nsBGR to nsRGB conversion." << endl;
-	  nsRGBtonRGB(nsRGB,nRGB);
-	  cout << "Completed nsRGB to nRGB conversion." << endl;
-	  nRGBtolRGB(nRGB,lRGB);
-	  cout << "Completed nRGB to lRGB conversion." << endl;
-	  lRGBtoXYZ(lRGB,XYZ);
-	  cout << "Completed lRGB to XYZ conversion." << endl;
-	  XYZtoLuv(XYZ,Luv);
-	  cout << "Completed XYZ to Luv conversion." << endl;
+	  nsRGBtoLuv(nsRGB,Luv);
+	  cout << "Completed nsRGB to Luv conversion." << endl;
 
 	  //Stretch L in window in Luv image
-	  WindowStretchLuv(Luv, stretchLuv, w1, w2, h1, h2);
+	  WindowStretchLuv(Luv, Luv, w1, w2, h1, h2);
 	  cout << "Completed L stretch using window L values." << endl;
 
-	  //Convert stretched Luv to nonlinear scaled RGB in 4 steps
-	  LuvtoXYZ(stretchLuv,XYZ2);
-	  cout << "Completed LuV to XYZ conversion." << endl;
-	  XYZtolRGB(XYZ2,lRGB2);
-  	  cout << "Completed Luv to lRGB conversion." << endl;
-  	  lRGBtonRGB(lRGB2,nRGB2);
-  	  cout << "Completed Luv to nRGB conversion." << endl;
-  	  nRGBtonsRGB(nRGB2,outputImage);
+	  //Convert stretched Luv to nonlinear scaled RGB in 1 step, back into the byte image
+  	  LuvtonsRGB(Luv,nsRGB);
   	  cout << "Completed Luv to nsRGB conversion." << endl;
 
   	  //Convert RGB to BGR
-  	  cvtColor(outputImage, outputImageBGR, COLOR_RGB2BGR);
+  	  cvtColor(nsRGB, nsRGB, COLOR_RGB2BGR);
 
   	  cout << "All conversions complete." << endl;
 
   	  //Show the stretched Luv image converted to non-linear scaled BGR
   	  namedWindow("L stretched image",WINDOW_AUTOSIZE);
-  	  imshow("L stretched image", outputImageBGR);
+  	  imshow("L stretched image", nsRGB);
   	  waitKey(0); // Wait for a keystroke
 
   	  //Write out output image
-  	  imwrite(outputName,outputImageBGR);
+  	  imwrite(outputName,nsRGB);
 
 return(0);
 }
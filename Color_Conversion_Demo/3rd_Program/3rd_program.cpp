@@ -69,78 +69,27 @@ int main(int argc, char** argv) {
 	    cout <<  inputName << " is not a standard 8UC3 color image  " << endl;
 	    return(-1);
 	  }
-	  int depth1 = CV_8UC3;
-	  int depth2 = CV_32FC3;
-	  int height = inputImage.rows;
-	  int width = inputImage.cols;
 
 	  cout << "Starting color conversions." << endl;
 
-	  //Convert input image (nsRGB) to Luv in 5 steps
-	  Mat nsRGB(height, width, depth1);
-  	  cvtColor(inputImage, nsRGB, COLOR_RGB2BGR);
-  	  cout << "Completed nsBGR to nsRGB conversion." << endl;
-
-	  Mat nRGB(height, width, depth2);
-	  nsRGBtonRGB(nsRGB,nRGB);
-	  ~nsRGB;
-	  cout << "Completed nsRGB to nRGB conversion." << endl;
-
-	  Mat lRGB(height, width, depth2);
-	  nRGBtolRGB(nRGB,lRGB);
-	  ~nRGB;
-	  cout << "Completed nRGB to lRGB conversion." << endl;
-
-	  Mat XYZ(height, width, depth2);
-	  lRGBtoXYZ(lRGB,XYZ);
-	  ~lRGB;
-	  cout << "Completed lRGB to XYZ conversion." << endl;
-
-	  Mat Luv(height, width, depth2);
-	  XYZtoLuv(XYZ,Luv);
-	  ~XYZ;
-	  cout << "Completed XYZ to Luv conversion." << endl;
-
-	  //Stretch L in window in Luv image
-	  Mat equLuv(height, width, depth2);
-	  LequLuv(Luv, equLuv, w1, w2, h1, h2);
-	  ~Luv;
-	  cout << "Completed L equalization using window L values." << endl;
-
-	  //Convert stretched Luv to nonlinear scaled RGB in 4 steps
-	  Mat XYZ2(height, width, depth2);
-	  LuvtoXYZ(equLuv,XYZ2);
-	  ~equLuv;
-	  cout << "Completed Luv to XYZ conversion." << endl;
-
-	  Mat lRGB2(height, width, depth2);
-	  XYZtolRGB(XYZ2,lRGB2);
-	  ~XYZ2;
-  	  cout << "Completed XYZ to lRGB conversion." << endl;
-
-	  Mat nRGB2(height, width, depth2);
-  	  lRGBtonRGB(lRGB2,nRGB2);
-  	  ~lRGB2;
-  	  cout << "Completed lRGB to nRGB conversion." << endl;
-
-	  Mat outputImage(height, width, depth1);
-  	  nRGBtonsRGB(nRGB2,outputImage);
-  	  ~nRGB2;
-  	  cout << "Completed nRGB to nsRGB conversion." << endl;
-
-  	  //Convert RGB to BGR
-	  Mat outputImageBGR(height, width, depth1);
-  	  cvtColor(outputImage, outputImageBGR, COLOR_RGB2BGR);
-  	  ~outputImage;
-  	  cout << "All conversions complete." << endl;
+	  //The whole chain is described once and planned by the library: the R and B swaps fold into
+	  //the matrices and every pixel goes from nsBGR to Luv, through the L equalization and back
+	  //to nsBGR in one pass, in place in the byte image
+	  Mat nsBGR = inputImage;
+	  ConversionGraph equalizeL(SPACE_nsBGR);
+	  equalizeL.to(SPACE_Luv).equalize(w1, w2, h1, h2).to(SPACE_nsBGR);
+	  cout << equalizeL.plan();
+
+	  equalizeL.run(nsBGR, nsBGR);
+	  cout << "All conversions complete." << endl;
 
   	  //Show the stretched Luv image converted to non-linear scaled BGR
   	  namedWindow("L equalized image",WINDOW_AUTOSIZE);
-  	  imshow("L equalized image", outputImageBGR);
+  	  imshow("L equalized image", nsBGR);
   	  waitKey(0); // Wait for a keystroke
 
   	  //Write out output image
-  	  imwrite(outputName,outputImageBGR);
+  	  imwrite(outputName,nsBGR);
 
 return(0);
 }
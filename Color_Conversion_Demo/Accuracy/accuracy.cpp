@@ -0,0 +1,430 @@
+/* MIT License
+ 
+ Copyright (c) 2019 Shane Zabel 
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ =============================================================================
+
+ Accuracy report of the approximate color conversion paths against the exact ones
+*/
+
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <vector>
+#include "color_conversions.hpp"
+#include "color_fastmath.hpp"
+
+using namespace cv;
+using namespace std;
+
+//Number of evenly spaced samples in each sweep of [0,1]
+static const int samples = 1<<24;
+
+//Function prints one result line and returns false when the error exceeds its bound
+static bool report(const string& name, double error, double bound){
+	bool pass = error<=bound;
+	cout << left << setw(28) << name
+	     << right << setw(12) << scientific << setprecision(2) << error
+	     << setw(12) << bound
+	     << (pass ? "    ok" : "    FAILED") << endl;
+	return pass;
+}
+
+//Function returns the maximum relative error of an approximate power against pow()
+//for x in [lo,1]
+static double powerError(float (*approx)(float), double p, float lo){
+	double worst=0.0;
+
+	for(int i = 0 ; i <= samples ; i++){
+		float x=lo+(1.0f-lo)*(float)(i/(double)samples);
+		if(x<=0.0f) continue;
+		double exact=pow((double)x,p);
+		worst=max(worst,fabs(approx(x)/exact-1.0));
+	}
+	return worst;
+}
+
+//Function returns the largest absolute difference between two conversions of the same image,
+//the first with pow() and the second with the polynomial approximations
+static double conversionError(void (*conversion)(const Mat&, Mat&), const Mat& input){
+	Mat exact, approx;
+
+	setUseFastMath(false);
+	conversion(input, exact);
+	setUseFastMath(true);
+	conversion(input, approx);
+	setUseFastMath(false);
+	return norm(exact, approx, NORM_INF);
+}
+
+//Function converts an nsRGB image to Luv and back with the given intermediate depth
+static Mat roundTrip(const Mat& nsRGB, int depth){
+	Mat Luv, result;
+
+	setIntermediateDepth(depth);
+	nsRGBtoLuv(nsRGB, Luv);
+	LuvtonsRGB(Luv, result);
+	setIntermediateDepth(CV_32F);
+	return result;
+}
+
+//Function returns the largest CIE 1976 color difference, Delta E*uv, between two nsRGB images,
+//over the pixels a CV_8U mask marks or over every pixel without one
+static double maxDeltaE(const Mat& nsRGB1, const Mat& nsRGB2, const Mat& mask=Mat()){
+	Mat Luv1, Luv2;
+	double worst=0.0;
+
+	nsRGBtoLuv(nsRGB1, Luv1);
+	nsRGBtoLuv(nsRGB2, Luv2);
+	for(int i = 0 ; i < Luv1.rows ; i++){
+		const Vec3f* row1=Luv1.ptr<Vec3f>(i);
+		const Vec3f* row2=Luv2.ptr<Vec3f>(i);
+		const uchar* marked=mask.empty() ? 0 : mask.ptr<uchar>(i);
+		for(int j = 0 ; j < Luv1.cols ; j++){
+			if(marked && !marked[j]) continue;
+			double dL=row1[j][0]-row2[j][0];
+			double du=row1[j][1]-row2[j][1];
+			double dv=row1[j][2]-row2[j][2];
+			worst=max(worst,sqrt(dL*dL+du*du+dv*dv));
+		}
+	}
+	return worst;
+}
+
+//Function reports the difference half float Luv makes to the round trip of an image, between
+//the results with 32 bit and with 16 bit float intermediates, as the largest change of an 8 bit
+//value and as the largest Delta E*uv. A Delta E around 2.3 is one just noticeable difference
+static bool reportRoundTrip(const string& name, const Mat& nsRGB){
+	Mat single=roundTrip(nsRGB, CV_32F);
+	Mat half=roundTrip(nsRGB, CV_16F);
+
+	bool pass=report(name+" 8 bit", norm(single, half, NORM_INF), 2.0);
+	pass&=report(name+" Delta E", maxDeltaE(single, half), 2.0);
+	return pass;
+}
+
+//8 bit enhancement flows compared between the float and the fixed point pipelines
+enum Flow { roundTripLuv, stretchL, equalizeL, stretchY };
+static const char* flowNames[] = { "Luv", "stretch L", "equalize L", "stretch Y" };
+
+//Function runs one 8 bit flow on an nsRGB image with the float or the fixed point pipeline,
+//window operations use the window 0.1-0.9 in both directions. The float pipeline can also
+//return the Luv image its last conversion starts from
+static Mat runFlow(Flow flow, const Mat& nsRGB, bool fixedPoint, Mat* Luv=0){
+	Mat image, result;
+
+	if(flow==stretchY){
+		if(fixedPoint){
+			nsRGBtoxyYFixed(nsRGB, image);
+			WindowStretchxyYFixed(image, image, 0.1, 0.9, 0.1, 0.9);
+			xyYFixedtonsRGB(image, result);
+		}else{
+			nsRGBtoxyY(nsRGB, image);
+			WindowStretchxyY(image, image, 0.1, 0.9, 0.1, 0.9);
+			xyYtonsRGB(image, result);
+			if(Luv){
+				xyYtoXYZ(image, image);
+				XYZtoLuv(image, *Luv);
+			}
+		}
+	}else if(fixedPoint){
+		nsRGBtoLuvFixed(nsRGB, image);
+		if(flow==stretchL) WindowStretchLuvFixed(image, image, 0.1, 0.9, 0.1, 0.9);
+		if(flow==equalizeL) LequLuvFixed(image, image, 0.1, 0.9, 0.1, 0.9);
+		LuvFixedtonsRGB(image, result);
+	}else{
+		nsRGBtoLuv(nsRGB, image);
+		if(flow==stretchL) WindowStretchLuv(image, image, 0.1, 0.9, 0.1, 0.9);
+		if(flow==equalizeL) LequLuv(image, image, 0.1, 0.9, 0.1, 0.9);
+		LuvtonsRGB(image, result);
+		if(Luv) *Luv=image;
+	}
+	return result;
+}
+
+//Function marks the pixels of a float Luv image where the conversion back to nsRGB is well
+//conditioned, with a saturation sqrt(u*u+v*v)/L no higher than the 4.05 of the sRGB blue primary.
+//The chromaticity follows from u/L and v/L, so where stretching or equalizing leaves u and v far
+//larger than L, near black or below the vprime cut-off of LuvtoXYZ, a step of L moves the color
+//far out of gamut in both pipelines
+static Mat wellConditioned(const Mat& Luv){
+	Mat mask(Luv.rows, Luv.cols, CV_8UC1);
+
+	for(int i = 0 ; i < Luv.rows ; i++){
+		const Vec3f* row=Luv.ptr<Vec3f>(i);
+		uchar* marked=mask.ptr<uchar>(i);
+		for(int j = 0 ; j < Luv.cols ; j++){
+			float L=row[j][0];
+			marked[j]=(L>0.0f && hypot(row[j][1], row[j][2])<=4.1f*L) ? 1 : 0;
+		}
+	}
+	return mask;
+}
+
+//Function returns the share of 8 bit values of two images that are more than levels apart
+static double shareOver(const Mat& nsRGB1, const Mat& nsRGB2, int levels){
+	long over=0;
+
+	for(int i = 0 ; i < nsRGB1.rows ; i++){
+		const uchar* row1=nsRGB1.ptr<uchar>(i);
+		const uchar* row2=nsRGB2.ptr<uchar>(i);
+		for(int j = 0 ; j < nsRGB1.cols*3 ; j++){
+			if(abs(row1[j]-row2[j])>levels) over++;
+		}
+	}
+	return over/(nsRGB1.total()*3.0);
+}
+
+//Function reports the difference between the float and the fixed point pipelines for every flow,
+//as the largest change of an 8 bit value and the largest Delta E*uv over the well conditioned
+//pixels, and as the share of all values more than 2 levels apart. Equalizing maps L to steps of
+//one unit and the two pipelines put some pixels one or two steps apart, which on dark saturated
+//colors moves a channel near 0 by up to about 30 levels
+static bool reportFixedPoint(const string& name, const Mat& nsRGB){
+	const double maxBound[] = { 6.0, 6.0, 40.0, 3.0 };
+	const double deltaEBound[] = { 2.0, 2.0, 7.0, 2.0 };
+	const double shareBound[] = { 5.0e-3, 3.0e-3, 1.5e-2, 1.0e-6 };
+	bool pass=true;
+
+	for(int f = roundTripLuv ; f <= stretchY ; f++){
+		Mat Luv;
+		Mat single=runFlow((Flow)f, nsRGB, false, &Luv);
+		Mat fixedPoint=runFlow((Flow)f, nsRGB, true);
+		Mat mask=wellConditioned(Luv);
+		pass&=report(name+" "+flowNames[f]+" 8 bit", norm(single, fixedPoint, NORM_INF, mask), maxBound[f]);
+		pass&=report(name+" "+flowNames[f]+" Delta E", maxDeltaE(single, fixedPoint, mask), deltaEBound[f]);
+		pass&=report(name+" "+flowNames[f]+" >2", shareOver(single, fixedPoint, 2), shareBound[f]);
+	}
+	return pass;
+}
+
+//Function returns the difference in 8 bit levels that 99 percent of the values of two images stay within
+static double percentile99(const Mat& nsRGB1, const Mat& nsRGB2){
+	double hist[256]={0};
+
+	for(int i = 0 ; i < nsRGB1.rows ; i++){
+		const uchar* row1=nsRGB1.ptr<uchar>(i);
+		const uchar* row2=nsRGB2.ptr<uchar>(i);
+		for(int j = 0 ; j < nsRGB1.cols*3 ; j++) hist[abs(row1[j]-row2[j])]++;
+	}
+
+	double accum=0.0;
+	for(int k = 0 ; k < 256 ; k++){
+		accum+=hist[k];
+		if(accum>=0.99*nsRGB1.total()*3) return k;
+	}
+	return 255.0;
+}
+
+//Function reports the difference between the 3D lookup table conversions and the float pipeline,
+//as the difference 99 percent of the 8 bit values stay within. The table meets the error bound
+//before its results are truncated to 8 bits, which adds up to one level
+static bool reportLUT(const string& name, const Mat& nsRGB){
+	Mat Luv, single, table;
+	bool pass=true;
+
+	nsRGBtoLuv(nsRGB, Luv);
+	WindowStretchLuv(Luv, Luv, 0.1, 0.9, 0.1, 0.9);
+	LuvtonsRGB(Luv, single);
+	WindowStretchLuvLUT(nsRGB, table, 0.1, 0.9, 0.1, 0.9);
+	pass&=report(name+" stretch L p99", percentile99(single, table), getLutErrorBound()+1.0);
+
+	nsRGBtoLuv(nsRGB, Luv);
+	LequLuv(Luv, Luv, 0.1, 0.9, 0.1, 0.9);
+	LuvtonsRGB(Luv, single);
+	LequLuvLUT(nsRGB, table, 0.1, 0.9, 0.1, 0.9);
+	pass&=report(name+" equalize L p99", percentile99(single, table), getLutErrorBound()+1.0);
+	return pass;
+}
+
+//Function reports the difference between conversion graphs and the hand wired float flows.
+//The graphs run the same kernels without intermediate images, so the results match exactly.
+//The plain Luv round trip is left out, a graph drops it and returns its input
+static bool reportGraph(const string& name, const Mat& nsRGB){
+	bool pass=true;
+
+	for(int f = stretchL ; f <= stretchY ; f++){
+		ConversionGraph graph(SPACE_nsRGB);
+		if(f==stretchY) graph.to(SPACE_xyY).windowStretch(0.1, 0.9, 0.1, 0.9);
+		else graph.to(SPACE_Luv);
+		if(f==stretchL) graph.windowStretch(0.1, 0.9, 0.1, 0.9);
+		if(f==equalizeL) graph.equalize(0.1, 0.9, 0.1, 0.9);
+		graph.to(SPACE_nsRGB);
+
+		//Streaming in bands of 61 rows gives the same statistics and so the same result
+		Mat fused;
+		MatBandSource source(nsRGB);
+		MatBandSink banded;
+		graph.run(nsRGB, fused);
+		graph.stream(source, banded, 61);
+		pass&=report(name+" "+flowNames[f]+" 8 bit", norm(runFlow((Flow)f, nsRGB, false), fused, NORM_INF), 0.0);
+		pass&=report(name+" "+flowNames[f]+" banded", norm(fused, banded.image, NORM_INF), 0.0);
+	}
+	return pass;
+}
+
+//Function reports the difference between a batch of windows and the single window float flows.
+//The batch shares the forward conversion and runs the same remap and return path, so the results match exactly
+static bool reportBatch(const string& name, const Mat& nsRGB){
+	bool pass=true;
+	vector<StretchWindow> windows(2);
+	StretchWindow flowWindow={0.1, 0.9, 0.1, 0.9};
+	StretchWindow otherWindow={0.2, 0.5, 0.1, 0.3};
+	windows[0]=otherWindow;
+	windows[1]=flowWindow;
+	BatchOperation operations[]={batchStretchL, batchEqualizeL, batchStretchY};
+
+	for(int f = stretchL ; f <= stretchY ; f++){
+		vector<Mat> outputs;
+		BatchWindows(nsRGB, operations[f-stretchL], windows, outputs);
+		pass&=report(name+" "+flowNames[f]+" 8 bit", norm(runFlow((Flow)f, nsRGB, false), outputs[1], NORM_INF), 0.0);
+	}
+	return pass;
+}
+
+//Function reports the difference between window stretches that read the window statistics from a
+//MinMaxTable and ones that scan the window, over windows that do and don't line up with its blocks.
+//Windows are scaled by the image height in both directions, so on the portrait left half of the
+//image the wider windows reach past its columns and both paths clip them
+static bool reportMinMaxTable(const string& name, const Mat& nsRGB){
+	bool pass=true;
+	Mat Luv, xyY, scanned, table;
+	double windows[4][4]={{0.1, 0.9, 0.1, 0.9}, {0.0, 1.0, 0.0, 1.0}, {0.33, 0.41, 0.6, 0.61}, {0.3, 0.8, 0.1, 0.9}};
+	Mat shapes[2]={nsRGB, nsRGB(Rect(0, 0, nsRGB.cols/2, nsRGB.rows)).clone()};
+	const string shapeNames[2]={"", " portrait"};
+
+	for(int s = 0 ; s < 2 ; s++){
+		nsRGBtoLuv(shapes[s], Luv);
+		nsRGBtoxyY(shapes[s], xyY);
+		MinMaxTable L, Y;
+		L.build(Luv, 0);
+		Y.build(xyY, 2);
+		for(int w = 0 ; w < 4 ; w++){
+			const double* c=windows[w];
+			WindowStretchLuv(Luv, scanned, c[0], c[1], c[2], c[3]);
+			WindowStretchLuv(Luv, table, L, c[0], c[1], c[2], c[3]);
+			pass&=report(name+shapeNames[s]+" stretch L "+to_string(w), norm(scanned, table, NORM_INF), 0.0);
+			WindowStretchxyY(xyY, scanned, c[0], c[1], c[2], c[3]);
+			WindowStretchxyY(xyY, table, Y, c[0], c[1], c[2], c[3]);
+			pass&=report(name+shapeNames[s]+" stretch Y "+to_string(w), norm(scanned, table, NORM_INF), 0.0);
+		}
+	}
+	return pass;
+}
+
+//Function reports the difference between the single pass adaptive equalization to nsRGB and
+//AdaptiveLequLuv followed by LuvtonsRGB. Both blend the same tile maps, so the results match exactly
+static bool reportAdaptive(const string& name, const Mat& nsRGB){
+	Mat Luv, equLuv, separate, fused;
+
+	nsRGBtoLuv(nsRGB, Luv);
+	AdaptiveLequLuv(Luv, equLuv, 8, 8, 2.0);
+	LuvtonsRGB(equLuv, separate);
+	AdaptiveLequLuvtonsRGB(Luv, fused, 8, 8, 2.0);
+	return report(name+" 8x8 tiles 8 bit", norm(separate, fused, NORM_INF), 0.0);
+}
+
+//A section of the report, run over every 8 bit color and over the images on the command line
+struct ImageCheck {
+	const char* title;
+	bool (*check)(const string& name, const Mat& nsRGB);
+};
+
+static const ImageCheck imageChecks[] = {
+	//Delta E*uv of nsRGB to Luv and back
+	{"CV_16F round trip", reportRoundTrip},
+	//Difference of the fixed point pipeline from the float pipeline on the same images
+	{"Fixed point vs float", reportFixedPoint},
+	//Difference of the 3D lookup table conversions from the float pipeline
+	{"3D LUT vs float", reportLUT},
+	//Difference of the conversion graphs from the hand wired float flows
+	{"Conversion graph vs float", reportGraph},
+	//Difference of the batch of windows from the single window flows
+	{"Batch windows vs float", reportBatch},
+	//Difference of the window stretches through a MinMaxTable from the ones scanning the window
+	{"MinMaxTable vs scan", reportMinMaxTable},
+	//Difference of the single pass adaptive equalization from the two pass one
+	{"Adaptive L single pass", reportAdaptive}
+};
+
+//Function prints the title line of a section of the report
+static void reportTitle(const string& title){
+	cout << left << setw(28) << title
+	     << right << setw(12) << "max error" << setw(12) << "bound" << endl;
+}
+
+int main(int argc, char** argv) {
+	bool pass=true;
+
+	reportTitle("Approximation");
+
+	//Relative error of the powers over the ranges where the conversions use them
+	pass &= report("x^2.4 on [0.0894,1]", powerError(fastPow2_4, 2.4, 0.0894f), 1.0e-6);
+	pass &= report("x^(1/2.4) on [0.00304,1]", powerError(fastPow1_2_4, 1.0/2.4, 0.00304f), 3.5e-7);
+	pass &= report("cbrt on [0.008856,1]", powerError(fastCbrt, 1.0/3.0, 0.008856f), 2.5e-7);
+	pass &= report("x^(1/2.4) on (0,1]", powerError(fastPow1_2_4, 1.0/2.4, 0.0f), 7.0e-7);
+	pass &= report("cbrt on (0,1]", powerError(fastCbrt, 1.0/3.0, 0.0f), 2.5e-6);
+
+	//Ramp image covering [0,1] in every channel, used as nRGB, lRGB and XYZ
+	Mat ramp(1, samples+1, CV_32FC3);
+	Vec3f* pixel=ramp.ptr<Vec3f>(0);
+	for(int i = 0 ; i <= samples ; i++){
+		float v=(float)(i/(double)samples);
+		pixel[i]=Vec3f(v,v,v);
+	}
+
+	//Absolute error of the conversions, [0-1] for RGB and [0-100] for L
+	pass &= report("nRGBtolRGB", conversionError(nRGBtolRGB, ramp), 1.0e-6);
+	pass &= report("lRGBtonRGB", conversionError(lRGBtonRGB, ramp), 1.0e-6);
+	pass &= report("XYZtoLuv", conversionError(XYZtoLuv, ramp), 1.0e-4);
+
+	//Every 8 bit color and the images on the command line, which are read as BGR and converted as RGB.
+	//Example: Accuracy ../data/fruits.jpg ../../data/lena.ppm
+	Mat colors(4096, 4096, CV_8UC3);
+	for(int i = 0 ; i < colors.rows ; i++){
+		Vec3b* row=colors.ptr<Vec3b>(i);
+		for(int j = 0 ; j < colors.cols ; j++){
+			int color=i*colors.cols+j;
+			row[j]=Vec3b(color>>16, (color>>8)&255, color&255);
+		}
+	}
+	vector<string> names(1, "all colors");
+	vector<Mat> images(1, colors);
+	for(int a = 1 ; a < argc ; a++){
+		Mat image = imread(argv[a]);
+		if(image.empty()){
+			cout << "Could not open or find the image " << argv[a] << endl;
+			pass=false;
+			continue;
+		}
+		cvtColor(image, image, COLOR_BGR2RGB);
+		names.push_back(argv[a]);
+		images.push_back(image);
+	}
+
+	for(size_t c = 0 ; c < sizeof(imageChecks)/sizeof(imageChecks[0]) ; c++){
+		cout << endl;
+		reportTitle(imageChecks[c].title);
+		for(size_t i = 0 ; i < images.size() ; i++) pass &= imageChecks[c].check(names[i], images[i]);
+	}
+
+	return(pass ? 0 : -1);
+}
@@ -0,0 +1,272 @@
+/* MIT License
+ 
+ Copyright (c) 2019 Shane Zabel 
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ =============================================================================
+
+ Headless L stretch, L equalization or Y stretch of many images on a work-stealing pool of threads
+*/
+
+#include <opencv2/opencv.hpp>
+#include <sys/stat.h>
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "color_conversions.hpp"
+
+using namespace cv;
+using namespace std;
+
+//Work-stealing pool over a fixed list of tasks. Tasks are dealt round robin to one deque per worker,
+//a worker takes from the front of its own deque and, once that is empty, steals from the back of
+//the others, so workers that drew small images pick up the remaining work of the slow ones
+struct StealingPool {
+	vector<deque<int> > queues;
+	vector<mutex> locks;
+
+	StealingPool(int workers, int tasks) : queues(workers), locks(workers){
+		for(int t = 0 ; t < tasks ; t++) queues[t%workers].push_back(t);
+	}
+
+	//Function takes the next task of a worker, returns false once every deque is empty
+	bool take(int worker, int* task){
+		int workers=(int)queues.size();
+		for(int k = 0 ; k < workers ; k++){
+			int victim=(worker+k)%workers;
+			lock_guard<mutex> guard(locks[victim]);
+			if(queues[victim].empty()) continue;
+			if(k==0){
+				*task=queues[victim].front();
+				queues[victim].pop_front();
+			}else{
+				*task=queues[victim].back();
+				queues[victim].pop_back();
+			}
+			return true;
+		}
+		return false;
+	}
+};
+
+//Gate between small and large images. Any number of small images convert at once, each on the
+//thread of its worker, while a large image waits for them to finish and then converts alone
+//with every thread. Small images wait while a large one is waiting, so large images can't starve
+struct ImageGate {
+	mutex lock;
+	condition_variable changed;
+	int small;
+	int waitingLarge;
+	bool large;
+
+	ImageGate() : small(0), waitingLarge(0), large(false){}
+
+	void enter(bool isLarge){
+		unique_lock<mutex> guard(lock);
+		if(isLarge){
+			waitingLarge++;
+			changed.wait(guard, [this]{ return !large && small==0; });
+			waitingLarge--;
+			large=true;
+		}else{
+			changed.wait(guard, [this]{ return !large && waitingLarge==0; });
+			small++;
+		}
+	}
+
+	void leave(bool isLarge){
+		lock_guard<mutex> guard(lock);
+		if(isLarge) large=false;
+		else small--;
+		changed.notify_all();
+	}
+};
+
+//Pass through the gate held for the lifetime of the object, so the gate is left when a conversion throws
+struct GatePass {
+	ImageGate& gate;
+	bool isLarge;
+
+	GatePass(ImageGate& gate, bool isLarge) : gate(gate), isLarge(isLarge){ gate.enter(isLarge); }
+	~GatePass(){ gate.leave(isLarge); }
+};
+
+//Function returns true for a file name with the extension of an image format imread reads
+static bool isImageName(const string& name){
+	static const char* extensions[]={".jpg", ".jpeg", ".png", ".bmp", ".ppm", ".pgm", ".tif", ".tiff"};
+	size_t dot=name.find_last_of('.');
+	if(dot==string::npos) return false;
+	string extension=name.substr(dot);
+	for(size_t i = 0 ; i < extension.size() ; i++) extension[i]=(char)tolower(extension[i]);
+	for(size_t e = 0 ; e < sizeof(extensions)/sizeof(extensions[0]) ; e++){
+		if(extension==extensions[e]) return true;
+	}
+	return false;
+}
+
+//Function lists the images of a directory, or the names in a list file with one image per line
+static vector<string> listImages(const string& input){
+	vector<string> names;
+	struct stat info;
+
+	if(stat(input.c_str(), &info)==0 && (info.st_mode & S_IFDIR)){
+		vector<String> found;
+		glob(input+"/*", found, false);
+		for(size_t f = 0 ; f < found.size() ; f++){
+			if(isImageName(found[f])) names.push_back(found[f]);
+		}
+		return names;
+	}
+
+	ifstream list(input.c_str());
+	string line;
+	while(getline(list, line)){
+		if(!line.empty() && line[line.size()-1]=='\r') line.erase(line.size()-1);
+		if(!line.empty()) names.push_back(line);
+	}
+	return names;
+}
+
+//Function returns the value at a fraction of a sorted list, by nearest rank
+static double percentile(const vector<double>& sorted, double fraction){
+	if(sorted.empty()) return 0.0;
+	size_t rank=(size_t)ceil(fraction*sorted.size());
+	return sorted[std::min(std::max(rank, (size_t)1), sorted.size())-1];
+}
+
+int main(int argc, char** argv) {
+	if(argc < 8 || argc > 10) {
+	    cerr << argv[0] << ": "
+		 << "got " << argc-1
+		 << " arguments. Expecting seven to nine: stretch|equalize|stretchY w1 h1 w2 h2 InputDirOrList OutputDir [Workers] [LargeMP]."
+		 << endl ;
+	    cerr << "Example: BatchEnhance stretch 0.2 0.1 0.8 0.5 data results 8 4" << endl;
+	    return(-1);
+	  }
+	  string operation = argv[1];
+	  double w1 = atof(argv[2]);
+	  double h1 = atof(argv[3]);
+	  double w2 = atof(argv[4]);
+	  double h2 = atof(argv[5]);
+	  string inputName = argv[6];
+	  string outputDir = argv[7];
+	  int workers = argc > 8 ? atoi(argv[8]) : getConversionThreads();
+	  double largePixels = (argc > 9 ? atof(argv[9]) : 4.0)*1.0e6;
+
+	  if(operation != "stretch" && operation != "equalize" && operation != "stretchY") {
+	    cerr << " operation must be stretch, equalize or stretchY" << endl;
+	    return(-1);
+	  }
+	  if(w1<0 || h1<0 || w2<=w1 || h2<=h1 || w2>1 || h2>1) {
+	    cerr << " arguments must satisfy 0 <= w1 < w2 <= 1"
+		 << " ,  0 <= h1 < h2 <= 1" << endl;
+	    return(-1);
+	  }
+	  if(workers <= 0 || largePixels <= 0) {
+	    cerr << " workers and the large image size must be positive" << endl;
+	    return(-1);
+	  }
+
+	  vector<string> images = listImages(inputName);
+	  if(images.empty()) {
+	    cout << "Could not find any images in " << inputName << endl;
+	    return(-1);
+	  }
+
+	  //The same recipes as the demo programs, planned as conversion graphs on the BGR images imread returns
+	  ConversionGraph recipe(SPACE_nsBGR);
+	  if(operation == "stretch") recipe.to(SPACE_Luv).windowStretch(w1, w2, h1, h2);
+	  if(operation == "equalize") recipe.to(SPACE_Luv).equalize(w1, w2, h1, h2);
+	  if(operation == "stretchY") recipe.to(SPACE_xyY).windowStretch(w1, w2, h1, h2);
+	  recipe.to(SPACE_nsBGR);
+
+	  cout << "Processing " << images.size() << " images on " << workers << " workers, "
+	       << "images of " << largePixels/1.0e6 << " MP or more use every thread." << endl;
+
+	  vector<double> latency(images.size(), -1.0);
+	  vector<string> failures;
+	  mutex failureLock;
+	  StealingPool pool(workers, (int)images.size());
+	  ImageGate gate;
+
+	  int64 start = getTickCount();
+	  vector<thread> threads;
+	  for(int w = 0 ; w < workers ; w++) {
+	    threads.push_back(thread([&, w]{
+	      int task;
+	      while(pool.take(w, &task)) {
+	        int64 begin = getTickCount();
+	        string failure;
+	        try {
+	          Mat image = imread(images[task]);
+	          if(image.empty() || image.type() != CV_8UC3) {
+	            failure = images[task] + " is not a readable 8UC3 color image";
+	          } else {
+	            //Small images convert on this worker alone, large ones on every thread
+	            bool isLarge = image.total() >= largePixels;
+	            setThreadConversionThreads(isLarge ? 0 : 1);
+	            {
+	              GatePass pass(gate, isLarge);
+	              recipe.run(image, image);
+	            }
+
+	            string name = images[task].substr(images[task].find_last_of("/\\") + 1);
+	            if(!imwrite(outputDir + "/" + name, image)) failure = "Could not write " + outputDir + "/" + name;
+	          }
+	        } catch(const exception& error) {
+	          failure = images[task] + " failed: " + error.what();
+	        }
+
+	        //A failed image is reported after the run and the worker goes on with the next one
+	        if(!failure.empty()) {
+	          lock_guard<mutex> guard(failureLock);
+	          failures.push_back(failure);
+	          continue;
+	        }
+	        latency[task] = (getTickCount()-begin)/getTickFrequency();
+	      }
+	    }));
+	  }
+	  for(size_t t = 0 ; t < threads.size() ; t++) threads[t].join();
+	  double seconds = (getTickCount()-start)/getTickFrequency();
+
+	  vector<double> done;
+	  for(size_t i = 0 ; i < latency.size() ; i++) {
+	    if(latency[i] >= 0.0) done.push_back(latency[i]*1000.0);
+	  }
+	  sort(done.begin(), done.end());
+	  for(size_t f = 0 ; f < failures.size() ; f++) cout << "WARNING: " << failures[f] << endl;
+
+	  cout << done.size() << " of " << images.size() << " images in " << fixed << setprecision(2)
+	       << seconds << " s, " << done.size()/seconds << " images/s" << endl;
+	  cout << "Latency ms  p50 " << percentile(done, 0.50) << "  p90 " << percentile(done, 0.90)
+	       << "  p99 " << percentile(done, 0.99) << "  max " << percentile(done, 1.0) << endl;
+
+return(failures.empty() ? 0 : -1);
+}
@@ -0,0 +1,117 @@
+/* MIT License
+ 
+ Copyright (c) 2019 Shane Zabel 
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ =============================================================================
+
+ L stretch, L equalization or Y stretch of one image over a list of windows, with one forward conversion
+*/
+
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "color_conversions.hpp"
+
+using namespace cv;
+using namespace std;
+
+//Function returns the output name of window k, ImageOut with _k before its extension
+static string windowName(const string& outputName, int k){
+	size_t dot = outputName.find_last_of('.');
+	size_t slash = outputName.find_last_of('/');
+	if(dot == string::npos || (slash != string::npos && dot < slash)) dot = outputName.size();
+	return outputName.substr(0, dot) + "_" + to_string(k) + outputName.substr(dot);
+}
+
+int main(int argc, char** argv) {
+	//--cache CacheDir keeps the forward conversion for later runs on the same image, bounded to 1 GB
+	string cacheName;
+	if(argc > 2 && string(argv[1]) == "--cache") {
+	    cacheName = argv[2];
+	    argv += 2;
+	    argc -= 2;
+	  }
+	if(argc < 8 || (argc-4)%4 != 0) {
+	    cerr << argv[0] << ": "
+		 << "got " << argc-1
+		 << " arguments. Expecting [--cache CacheDir] stretch|equalize|stretchY ImageIn ImageOut and one or more windows w1 h1 w2 h2."
+		 << endl ;
+	    cerr << "Example: BatchWindows --cache cache stretch fruits.jpg out.bmp 0.2 0.1 0.8 0.5 0.0 0.0 0.5 0.5" << endl;
+	    return(-1);
+	  }
+	if(!cacheName.empty() && !setConversionCache(cacheName, (size_t)1<<30)) return(-1);
+	  string operation = argv[1];
+	  char *inputName = argv[2];
+	  string outputName = argv[3];
+
+	  BatchOperation batch;
+	  if(operation == "stretch") batch = batchStretchL;
+	  else if(operation == "equalize") batch = batchEqualizeL;
+	  else if(operation == "stretchY") batch = batchStretchY;
+	  else {
+	    cerr << " operation must be stretch, equalize or stretchY" << endl;
+	    return(-1);
+	  }
+
+	  //Windows are given as w1 h1 w2 h2, the order the single window demos take
+	  vector<StretchWindow> windows;
+	  for(int a = 4 ; a < argc ; a += 4) {
+	    StretchWindow window;
+	    window.w1 = atof(argv[a]);
+	    window.h1 = atof(argv[a+1]);
+	    window.w2 = atof(argv[a+2]);
+	    window.h2 = atof(argv[a+3]);
+	    if(window.w1<0 || window.h1<0 || window.w2<=window.w1 || window.h2<=window.h1 || window.w2>1 || window.h2>1) {
+	      cerr << " window " << windows.size() << " must satisfy 0 <= w1 < w2 <= 1"
+		   << " ,  0 <= h1 < h2 <= 1" << endl;
+	      return(-1);
+	    }
+	    windows.push_back(window);
+	  }
+
+	  Mat inputImage = imread(inputName);
+	  if(inputImage.empty()) {
+	    cout <<  "Could not open or find the image " << inputName << endl;
+	    return(-1);
+	  }
+	  if(inputImage.type() != CV_8UC3) {
+	    cout <<  inputName << " is not a standard 8UC3 color image  " << endl;
+	    return(-1);
+	  }
+
+	  //The image is decoded and converted once, every window only remaps and converts back
+	  Mat nsRGB;
+	  cvtColor(inputImage, nsRGB, COLOR_BGR2RGB);
+
+	  int64 start = getTickCount();
+	  vector<Mat> outputs;
+	  BatchWindows(nsRGB, batch, windows, outputs);
+	  cout << "Completed " << windows.size() << " windows in "
+	       << (getTickCount()-start)/getTickFrequency() << " s." << endl;
+
+	  for(size_t k = 0 ; k < outputs.size() ; k++) {
+	    cvtColor(outputs[k], outputs[k], COLOR_RGB2BGR);
+	    imwrite(windowName(outputName, (int)k), outputs[k]);
+	  }
+
+return(0);
+}
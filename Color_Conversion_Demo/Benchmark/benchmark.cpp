@@ -0,0 +1,570 @@
+/* MIT License
+ 
+ Copyright (c) 2019 Shane Zabel 
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ =============================================================================
+
+ Throughput benchmark of the color conversion algorithms using OpenCV
+*/
+
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <cstdlib>
+#include <vector>
+#include "color_conversions.hpp"
+#include "color_histogram.hpp"
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+using namespace cv;
+using namespace std;
+
+//Number of timed runs per conversion, the fastest run is reported
+static const int repeats = 3;
+
+//Hardware counters read around each case with --counters: cycles, instructions, last level cache
+//misses, data TLB misses and branch misses
+static const int counterCount = 5;
+static const char* counterNames[counterCount] = {"cycles", "instructions", "llc_misses", "dtlb_misses", "branch_misses"};
+
+//Counts of one run, valid is false when the counters were not read. A count is -1 when its counter is unavailable
+struct Counters {
+	bool valid;
+	long long count[counterCount];
+};
+
+//Fastest run of a case in seconds, the bytes it reads and writes per pixel and the counters of that run
+struct Timing {
+	double seconds;
+	double bytesPerPixel;
+	Counters counters;
+};
+
+//File descriptors of the open counters, -1 for a counter that could not be opened
+static int counterFds[counterCount] = {-1, -1, -1, -1, -1};
+static bool countersOpen = false;
+
+//Function opens the counters for the calling thread and returns false when none of them is available, as
+//on other systems than Linux or in containers that block perf_event_open. Counters that the processor or
+//the kernel does not offer are skipped on their own
+static bool openCounters(){
+#ifdef __linux__
+	unsigned long long cache=PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+	unsigned int types[counterCount] = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE};
+	unsigned long long configs[counterCount] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_CACHE_LL | cache, PERF_COUNT_HW_CACHE_DTLB | cache, PERF_COUNT_HW_BRANCH_MISSES};
+	int error=0;
+
+	for(int c = 0 ; c < counterCount ; c++){
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size=sizeof(attr);
+		attr.type=types[c];
+		attr.config=configs[c];
+		attr.disabled=1;
+		attr.exclude_kernel=1;
+		attr.exclude_hv=1;
+		attr.read_format=PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		counterFds[c]=(int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+		if(counterFds[c] < 0) error=errno;
+		else countersOpen=true;
+	}
+	if(!countersOpen) cout << "WARNING: hardware counters are not available (" << strerror(error) << "), timing only" << endl;
+#else
+	cout << "WARNING: hardware counters need Linux perf_event, timing only" << endl;
+#endif
+	return countersOpen;
+}
+
+//Function resets and starts the open counters. Counters follow the calling thread only, so they are
+//read for cases timed on one thread and left out of cases split across threads
+static void startCounters(){
+#ifdef __linux__
+	if(!countersOpen || getConversionThreads() != 1) return void();
+	for(int c = 0 ; c < counterCount ; c++){
+		if(counterFds[c] < 0) continue;
+		ioctl(counterFds[c], PERF_EVENT_IOC_RESET, 0);
+		ioctl(counterFds[c], PERF_EVENT_IOC_ENABLE, 0);
+	}
+#endif
+}
+
+//Function stops the counters started by startCounters and returns their counts, scaled up when the
+//kernel multiplexed a counter with others for part of the run
+static Counters stopCounters(){
+	Counters counters;
+	counters.valid=false;
+	for(int c = 0 ; c < counterCount ; c++) counters.count[c]=-1;
+#ifdef __linux__
+	if(!countersOpen || getConversionThreads() != 1) return counters;
+	for(int c = 0 ; c < counterCount ; c++){
+		if(counterFds[c] < 0) continue;
+		ioctl(counterFds[c], PERF_EVENT_IOC_DISABLE, 0);
+		unsigned long long value[3];
+		if(read(counterFds[c], value, sizeof(value)) != (ssize_t)sizeof(value) || value[2] == 0) continue;
+		counters.count[c]=(long long)((double)value[0]*value[1]/value[2]);
+	}
+	counters.valid=true;
+#endif
+	return counters;
+}
+
+//One reported line, kept for the JSON output
+struct Result {
+	string name;
+	string reference;
+	int width;
+	int height;
+	int threads;
+	double megapixels;
+	Timing timing;
+};
+
+//Image size and thread count of the cases being timed, and every line reported so far
+static int benchWidth=0;
+static int benchHeight=0;
+static vector<Result> results;
+
+//Function returns the bytes per pixel of reading input and writing output
+static double pixelBytes(const Mat& input, const Mat& output){
+	return (double)(input.elemSize()+output.elemSize());
+}
+
+//Function prints one result line in megapixels per second, nanoseconds and bytes per pixel and keeps it
+//for the JSON output. reference names the library case an OpenCV built-in is timed against
+static void report(const string& name, double megapixels, const Timing& timing, const string& reference = ""){
+	cout << left << setw(24) << name
+	     << right << setw(8) << fixed << setprecision(1) << megapixels << " MP"
+	     << setw(10) << setprecision(2) << timing.seconds*1000.0 << " ms"
+	     << setw(10) << setprecision(1) << megapixels/timing.seconds << " MPix/s"
+	     << setw(8) << setprecision(2) << timing.seconds*1000.0/megapixels << " ns/px"
+	     << setw(6) << setprecision(0) << timing.bytesPerPixel << " B/px" << endl;
+
+	//Cycles per pixel, instructions per cycle and misses per thousand pixels
+	if(timing.counters.valid){
+		const long long* count=timing.counters.count;
+		double pixels=megapixels*1.0e6;
+		cout << setw(24) << "" << setprecision(2);
+		if(count[0] >= 0) cout << "  cycles/px " << count[0]/pixels;
+		if(count[0] > 0 && count[1] >= 0) cout << "  IPC " << (double)count[1]/count[0];
+		const char* misses[3] = {"LLC", "dTLB", "branch"};
+		for(int c = 2 ; c < counterCount ; c++){
+			if(count[c] >= 0) cout << "  " << misses[c-2] << " miss/kpx " << count[c]*1000.0/pixels;
+		}
+		cout << endl;
+	}
+
+	Result result={name, reference, benchWidth, benchHeight, getConversionThreads(), megapixels, timing};
+	results.push_back(result);
+}
+
+//Function times a conversion from input to output and returns the fastest run
+static Timing timeConversion(void (*conversion)(const Mat&, Mat&), const Mat& input, Mat& output){
+	double best=0.0;
+	Counters counters;
+
+	for(int r = 0 ; r < repeats ; r++){
+		startCounters();
+		int64 start=getTickCount();
+		conversion(input, output);
+		double seconds=(getTickCount()-start)/getTickFrequency();
+		Counters counts=stopCounters();
+		if(r==0 || seconds<best){
+			best=seconds;
+			counters=counts;
+		}
+	}
+	Timing timing={best, pixelBytes(input, output), counters};
+	return timing;
+}
+
+//Function times a window conversion from input to output and returns the fastest run
+static Timing timeWindow(void (*conversion)(const Mat&, Mat&, double, double, double, double), const Mat& input, Mat& output){
+	double best=0.0;
+	Counters counters;
+
+	for(int r = 0 ; r < repeats ; r++){
+		startCounters();
+		int64 start=getTickCount();
+		conversion(input, output, 0.1, 0.9, 0.1, 0.9);
+		double seconds=(getTickCount()-start)/getTickFrequency();
+		Counters counts=stopCounters();
+		if(r==0 || seconds<best){
+			best=seconds;
+			counters=counts;
+		}
+	}
+	Timing timing={best, pixelBytes(input, output), counters};
+	return timing;
+}
+
+//Function times the OpenCV built-in conversion code from input to output and returns the fastest run.
+//cvtColor has no half float path, so a CV_16F input is widened to CV_32F before timing
+static Timing timeReference(int code, const Mat& input, Mat& output){
+	Mat source=input;
+	if(input.depth() == CV_16F) input.convertTo(source, CV_32F);
+	double best=0.0;
+	Counters counters;
+
+	for(int r = 0 ; r < repeats ; r++){
+		startCounters();
+		int64 start=getTickCount();
+		cvtColor(source, output, code);
+		double seconds=(getTickCount()-start)/getTickFrequency();
+		Counters counts=stopCounters();
+		if(r==0 || seconds<best){
+			best=seconds;
+			counters=counts;
+		}
+	}
+	Timing timing={best, pixelBytes(source, output), counters};
+	return timing;
+}
+
+//Function returns a timing measured once since start and the counters started with it, for cases that are not repeated
+static Timing timeSince(int64 start, double bytesPerPixel){
+	double seconds=(getTickCount()-start)/getTickFrequency();
+	Timing timing={seconds, bytesPerPixel, stopCounters()};
+	return timing;
+}
+
+//Function times loading a PPM or PGM file with imread and by mapping it. A first untimed
+//imread brings the file into the page cache, so both loads read it from memory
+static void timeRead(const string& path){
+	Mat decoded=imread(path, IMREAD_UNCHANGED);
+	if(decoded.empty()){
+		cout << "Could not open or find the image " << path << endl;
+		return void();
+	}
+	double megapixels=decoded.total()/1.0e6;
+
+	startCounters();
+	int64 start=getTickCount();
+	decoded=imread(path, IMREAD_UNCHANGED);
+	report("imread", megapixels, timeSince(start, (double)decoded.elemSize()));
+
+	MappedImage mapped;
+	startCounters();
+	start=getTickCount();
+	mapped.open(path);
+	report("MappedImage", megapixels, timeSince(start, (double)decoded.elemSize()));
+	cout << endl;
+}
+
+//Table of the L window statistics timed by the MinMaxTable cases
+static MinMaxTable tableL;
+
+//Function runs nsRGB to Luv, the window stretch of L and Luv to nsRGB as one conversion graph
+static void WindowStretchLuvGraph(const Mat& nsRGB, Mat& stretchRGB, double w1, double w2, double h1, double h2){
+	ConversionGraph graph(SPACE_nsRGB);
+	graph.to(SPACE_Luv).windowStretch(w1, w2, h1, h2).to(SPACE_nsRGB);
+	graph.run(nsRGB, stretchRGB);
+}
+
+//Function runs nsRGB to planar Luv, the window stretch of L and planar Luv to nsRGB
+static void WindowStretchLuvPlanar(const Mat& nsRGB, Mat& stretchRGB, double w1, double w2, double h1, double h2){
+	PlanarImage Luv, stretch;
+	nsRGBtoLuv(nsRGB, Luv);
+	WindowStretchLuv(Luv, stretch, w1, w2, h1, h2);
+	LuvtonsRGB(stretch, stretchRGB);
+}
+
+//Function times the window stretch of L over eight windows of an 8 bit image sharing one forward conversion
+static Timing timeBatch(const Mat& nsRGB){
+	vector<StretchWindow> windows;
+	for(int k = 0 ; k < 8 ; k++){
+		StretchWindow window={0.05*k, 0.5+0.05*k, 0.1, 0.9};
+		windows.push_back(window);
+	}
+	vector<Mat> outputs;
+	double best=0.0;
+	Counters counters;
+
+	for(int r = 0 ; r < repeats ; r++){
+		startCounters();
+		int64 start=getTickCount();
+		BatchWindows(nsRGB, batchStretchL, windows, outputs);
+		double seconds=(getTickCount()-start)/getTickFrequency();
+		Counters counts=stopCounters();
+		if(r==0 || seconds<best){
+			best=seconds;
+			counters=counts;
+		}
+	}
+	Timing timing={best, (double)nsRGB.elemSize()*(1+windows.size()), counters};
+	return timing;
+}
+
+//Function times the 256 bin histogram of the green channel of an 8 bit image and returns the fastest run
+static Timing timeHistogram(const Mat& nsRGB){
+	double best=0.0;
+	Counters counters;
+
+	for(int r = 0 ; r < repeats ; r++){
+		int hist[256]={0};
+		startCounters();
+		int64 start=getTickCount();
+		histogram8U(nsRGB, 1, Rect(0, 0, nsRGB.cols, nsRGB.rows), hist, getConversionThreads());
+		double seconds=(getTickCount()-start)/getTickFrequency();
+		Counters counts=stopCounters();
+		if(r==0 || seconds<best){
+			best=seconds;
+			counters=counts;
+		}
+	}
+	Timing timing={best, (double)nsRGB.elemSize(), counters};
+	return timing;
+}
+
+//Function writes every reported line as JSON to path and returns false when the file cannot be written
+static bool writeJson(const string& path){
+	ofstream out(path.c_str());
+	if(!out){
+		cout << "WARNING: could not write " << path << endl;
+		return false;
+	}
+	out << "{\n"
+	    << "  \"benchmark\": \"colorconv\",\n"
+	    << "  \"opencv\": \"" << CV_VERSION << "\",\n"
+	    << "  \"depth\": \"" << (getIntermediateDepth() == CV_16F ? "CV_16F" : "CV_32F") << "\",\n"
+	    << "  \"fast_math\": " << (useFastMath() ? "true" : "false") << ",\n"
+	    << "  \"repeats\": " << repeats << ",\n"
+	    << "  \"results\": [";
+	for(size_t k = 0 ; k < results.size() ; k++){
+		const Result& r=results[k];
+		out << (k ? ",\n" : "\n")
+		    << "    {\"name\": \"" << r.name << "\""
+		    << ", \"reference_for\": " << (r.reference.empty() ? "null" : "\""+r.reference+"\"")
+		    << ", \"width\": " << r.width << ", \"height\": " << r.height
+		    << ", \"threads\": " << r.threads
+		    << setprecision(6) << fixed
+		    << ", \"megapixels\": " << r.megapixels
+		    << ", \"ms\": " << r.timing.seconds*1000.0
+		    << ", \"mpix_per_s\": " << r.megapixels/r.timing.seconds
+		    << ", \"ns_per_pixel\": " << r.timing.seconds*1000.0/r.megapixels
+		    << ", \"bytes_per_pixel\": " << r.timing.bytesPerPixel
+		    << ", \"counters\": ";
+		if(!r.timing.counters.valid) out << "null";
+		else {
+			for(int c = 0 ; c < counterCount ; c++){
+				out << (c ? ", \"" : "{\"") << counterNames[c] << "\": ";
+				if(r.timing.counters.count[c] < 0) out << "null";
+				else out << r.timing.counters.count[c];
+			}
+			out << "}";
+		}
+		out << "}";
+	}
+	out << "\n  ]\n}\n";
+	return (bool)out;
+}
+
+//Function parses a comma separated list of positive thread counts into threads and returns false on a bad entry
+static bool parseThreads(const string& list, vector<int>& threads){
+	threads.clear();
+	size_t start=0;
+	while(start <= list.size()){
+		size_t end=list.find(',', start);
+		if(end == string::npos) end=list.size();
+		int count=atoi(list.substr(start, end-start).c_str());
+		if(count <= 0) return false;
+		threads.push_back(count);
+		start=end+1;
+	}
+	return !threads.empty();
+}
+
+int main(int argc, char** argv) {
+	//Image sizes in megapixels, either from the command line or the default sweep.
+	//--half stores the float images as CV_16F, --table <file> maps a Luv table made by LuvTable
+	//so nsRGBtoLuv and nsRGBtoLuvFixed time the table lookup, --read <file> times loading a PPM or PGM file,
+	//--threads <n,n,...> lists the thread counts every size is timed with, --json <file> writes the results and
+	//--counters reads the hardware counters around every case timed on one thread
+	vector<double> sizes;
+	vector<int> threads;
+	string jsonPath;
+	for(int a = 1 ; a < argc ; a++){
+		if(string(argv[a]) == "--read" && a+1 < argc){
+			timeRead(argv[++a]);
+			continue;
+		}
+		if(string(argv[a]) == "--half"){
+			setIntermediateDepth(CV_16F);
+			continue;
+		}
+		if(string(argv[a]) == "--table" && a+1 < argc){
+			if(!loadLuvTable(argv[++a])) return(-1);
+			continue;
+		}
+		if(string(argv[a]) == "--threads" && a+1 < argc){
+			if(!parseThreads(argv[++a], threads)) {
+				cerr << argv[0] << ": "
+				     << "--threads takes a comma separated list of positive thread counts." << endl;
+				return(-1);
+			}
+			continue;
+		}
+		if(string(argv[a]) == "--counters"){
+			openCounters();
+			continue;
+		}
+		if(string(argv[a]) == "--json" && a+1 < argc){
+			jsonPath=argv[++a];
+			continue;
+		}
+		double megapixels = atof(argv[a]);
+		if(megapixels <= 0.0) {
+			cerr << argv[0] << ": "
+			     << "arguments must be positive image sizes in megapixels." << endl;
+			cerr << "Example: Benchmark --read ../data/lena.ppm --half --table luv.table --counters --threads 1,4 --json bench.json 1 4 12 24 50" << endl;
+			return(-1);
+		}
+		sizes.push_back(megapixels);
+	}
+	if(sizes.empty()){
+		double defaults[] = {1, 4, 12, 24, 50};
+		sizes.assign(defaults, defaults+5);
+	}
+	//By default every size is timed on one thread and on all of them
+	int openCVThreads=getNumThreads();
+	if(threads.empty()){
+		threads.push_back(1);
+		if(getConversionThreads() > 1) threads.push_back(getConversionThreads());
+	}
+
+	for(size_t s = 0 ; s < sizes.size() ; s++){
+		for(size_t t = 0 ; t < threads.size() ; t++){
+			//The library and the OpenCV references run on the same number of threads
+			setConversionThreads(threads[t]);
+			setNumThreads(threads[t]);
+
+			//Synthetic 3:2 image with the requested number of pixels
+			int width = (int)sqrt(sizes[s]*1.0e6*1.5);
+			int height = (int)(sizes[s]*1.0e6/width);
+			double megapixels = width*(double)height/1.0e6;
+			benchWidth = width;
+			benchHeight = height;
+
+			cout << "Image " << width << "x" << height
+			     << (getIntermediateDepth() == CV_16F ? " CV_16F" : " CV_32F")
+			     << ", " << threads[t] << (threads[t] == 1 ? " thread" : " threads") << endl;
+
+			Mat nsRGB(height, width, CV_8UC3);
+			randu(nsRGB, Scalar::all(0), Scalar::all(256));
+			Mat A(height, width, CV_32FC3);
+			Mat B(height, width, CV_32FC3);
+			Mat out(height, width, CV_8UC3);
+			Mat ref;
+
+			//Forward path, each stage consumes the output of the previous one. lRGB to XYZ is the
+			//same matrix OpenCV applies to its RGB input, so COLOR_RGB2XYZ is timed on the linear image
+			report("nsRGBtonRGB", megapixels, timeConversion(nsRGBtonRGB, nsRGB, A));
+			report("nRGBtolRGB", megapixels, timeConversion(nRGBtolRGB, A, B));
+			report("lRGBtoXYZ", megapixels, timeConversion(lRGBtoXYZ, B, A));
+			report("cvtColor RGB2XYZ", megapixels, timeReference(COLOR_RGB2XYZ, B, ref), "lRGBtoXYZ");
+			report("XYZtoxyY", megapixels, timeConversion(XYZtoxyY, A, B));
+			report("xyYtoXYZ", megapixels, timeConversion(xyYtoXYZ, B, A));
+			report("XYZtoLuv", megapixels, timeConversion(XYZtoLuv, A, B));
+			report("nsRGBtolRGB", megapixels, timeConversion(nsRGBtolRGB, nsRGB, A));
+
+			//Window operations on the Luv image
+			report("stretchLuv", megapixels, timeConversion(stretchLuv, B, A));
+			report("WindowStretchLuv", megapixels, timeWindow(WindowStretchLuv, B, A));
+
+			//Window statistics from a table built once, as when the window moves interactively.
+			//The build only reads the image, so its bytes per pixel are those of the input
+			Timing build=timeConversion([](const Mat& Luv, Mat&){ tableL.build(Luv, 0); }, B, A);
+			build.bytesPerPixel=(double)B.elemSize();
+			report("MinMaxTable build", megapixels, build);
+			report("WindowStretchLuvTable", megapixels, timeWindow([](const Mat& Luv, Mat& stretchLuv, double w1, double w2, double h1, double h2){
+				WindowStretchLuv(Luv, stretchLuv, tableL, w1, w2, h1, h2);
+			}, B, A));
+			report("LequLuv", megapixels, timeWindow(LequLuv, B, A));
+			report("AdaptiveLequLuv", megapixels, timeConversion([](const Mat& Luv, Mat& equLuv){
+				AdaptiveLequLuv(Luv, equLuv, 8, 8, 2.0);
+			}, B, A));
+			report("AdaptiveLequLuvtonsRGB", megapixels, timeConversion([](const Mat& Luv, Mat& nsRGB){
+				AdaptiveLequLuvtonsRGB(Luv, nsRGB, 8, 8, 2.0);
+			}, B, out));
+
+			//Return path
+			report("LuvtoXYZ", megapixels, timeConversion(LuvtoXYZ, B, A));
+			report("XYZtolRGB", megapixels, timeConversion(XYZtolRGB, A, B));
+			report("cvtColor XYZ2RGB", megapixels, timeReference(COLOR_XYZ2RGB, A, ref), "XYZtolRGB");
+			report("lRGBtonRGB", megapixels, timeConversion(lRGBtonRGB, B, A));
+			report("nRGBtonsRGB", megapixels, timeConversion(nRGBtonsRGB, A, out));
+			report("lRGBtonsRGB", megapixels, timeConversion(lRGBtonsRGB, B, out));
+
+			//Window operation on the xyY image
+			XYZtoxyY(A, B);
+			report("WindowStretchxyY", megapixels, timeWindow(WindowStretchxyY, B, A));
+			report("xyYtonsRGB", megapixels, timeConversion(xyYtonsRGB, B, out));
+
+			//Single pass 8 bit flows, float against fixed point. OpenCV converts a [0-1] float RGB image
+			//with the sRGB gamma to float Luv, the nearest built-in to nsRGBtoLuv, and 8 bit RGB to 8 bit Luv
+			report("nsRGBtoLuv", megapixels, timeConversion(nsRGBtoLuv, nsRGB, A));
+			nsRGBtonRGB(nsRGB, B);
+			report("cvtColor RGB2Luv", megapixels, timeReference(COLOR_RGB2Luv, B, ref), "nsRGBtoLuv");
+			report("LuvtonsRGB", megapixels, timeConversion(LuvtonsRGB, A, out));
+			report("cvtColor Luv2RGB", megapixels, timeReference(COLOR_Luv2RGB, A, ref), "LuvtonsRGB");
+			report("nsRGBtoxyY", megapixels, timeConversion(nsRGBtoxyY, nsRGB, A));
+			Mat S(height, width, CV_16SC3);
+			Mat T(height, width, CV_16SC3);
+			report("nsRGBtoLuvFixed", megapixels, timeConversion(nsRGBtoLuvFixed, nsRGB, S));
+			report("cvtColor RGB2Luv 8U", megapixels, timeReference(COLOR_RGB2Luv, nsRGB, ref), "nsRGBtoLuvFixed");
+			report("WindowStretchLuvFixed", megapixels, timeWindow(WindowStretchLuvFixed, S, T));
+			report("LequLuvFixed", megapixels, timeWindow(LequLuvFixed, S, T));
+			report("LuvFixedtonsRGB", megapixels, timeConversion(LuvFixedtonsRGB, S, out));
+			report("cvtColor Luv2RGB 8U", megapixels, timeReference(COLOR_Luv2RGB, ref, out), "LuvFixedtonsRGB");
+			report("nsRGBtoxyYFixed", megapixels, timeConversion(nsRGBtoxyYFixed, nsRGB, S));
+			report("WindowStretchxyYFixed", megapixels, timeWindow(WindowStretchxyYFixed, S, T));
+			report("xyYFixedtonsRGB", megapixels, timeConversion(xyYFixedtonsRGB, T, out));
+
+			//Whole 8 bit flows through a per-image 3D lookup table
+			report("WindowStretchLuvLUT", megapixels, timeWindow(WindowStretchLuvLUT, nsRGB, out));
+			report("LequLuvLUT", megapixels, timeWindow(LequLuvLUT, nsRGB, out));
+
+			//Whole 8 bit flows planned as a conversion graph and through planar Luv
+			report("WindowStretchLuvGraph", megapixels, timeWindow(WindowStretchLuvGraph, nsRGB, out));
+			report("WindowStretchLuvPlanar", megapixels, timeWindow(WindowStretchLuvPlanar, nsRGB, out));
+
+			//Eight windows over one forward conversion
+			report("BatchWindows x8", megapixels, timeBatch(nsRGB));
+
+			//Parallel histogram engine shared with Image_Threshold
+			report("histogram8U", megapixels, timeHistogram(nsRGB));
+			cout << endl;
+		}
+	}
+	setConversionThreads(0);
+	setNumThreads(openCVThreads);
+
+	if(!jsonPath.empty() && !writeJson(jsonPath)) return(-1);
+
+	return(0);
+}
@@ -0,0 +1,62 @@
+/* MIT License
+ 
+ Copyright (c) 2019 Shane Zabel 
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ =============================================================================
+
+ Precomputes the nsRGB to Luv table that batch jobs map with loadLuvTable
+*/
+
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include "color_conversions.hpp"
+
+using namespace cv;
+using namespace std;
+
+int main(int argc, char** argv) {
+	if(argc != 2) {
+	    cerr << argv[0] << ": "
+		 << "got " << argc-1
+		 << " arguments. Expecting one: TableOut."
+		 << endl ;
+	    cerr << "Example: LuvTable luv.table" << endl;
+	    return(-1);
+	  }
+	  string tableName = argv[1];
+
+	  cout << "Computing Luv for all 16777216 nsRGB colors." << endl;
+	  int64 start=getTickCount();
+	  if(!writeLuvTable(tableName)) return(-1);
+	  cout << "Wrote " << tableName << " in "
+	       << (getTickCount()-start)/getTickFrequency() << " s." << endl;
+
+	  //Map the written file the way batch jobs will, so a bad table is caught here
+	  if(!loadLuvTable(tableName)) return(-1);
+	  Mat nsRGB(1, 1, CV_8UC3, Scalar(255, 255, 255));
+	  Mat Luv;
+	  nsRGBtoLuvFixed(nsRGB, Luv);
+	  Vec3s white=Luv.at<Vec3s>(0, 0);
+	  cout << "Table maps white to L=" << white[0]/128.0 << " u=" << white[1]/128.0
+	       << " v=" << white[2]/128.0 << "." << endl;
+	  unloadLuvTable();
+
+return(0);
+}
@@ -0,0 +1,86 @@
+/* MIT License
+ 
+ Copyright (c) 2019 Shane Zabel 
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ =============================================================================
+
+ Banded L stretch and equalization of PPM images larger than memory
+*/
+
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <cstdlib>
+#include "color_conversions.hpp"
+
+using namespace cv;
+using namespace std;
+
+int main(int argc, char** argv) {
+	if(argc != 8 && argc != 9) {
+	    cerr << argv[0] << ": "
+		 << "got " << argc-1
+		 << " arguments. Expecting seven or eight: stretch|equalize w1 h1 w2 h2 ImageIn ImageOut [BandRows]."
+		 << endl ;
+	    cerr << "Example: StreamEnhance stretch 0.2 0.1 0.8 0.5 scan.ppm out.ppm 512" << endl;
+	    return(-1);
+	  }
+	  string operation = argv[1];
+	  double w1 = atof(argv[2]);
+	  double h1 = atof(argv[3]);
+	  double w2 = atof(argv[4]);
+	  double h2 = atof(argv[5]);
+	  char *inputName = argv[6];
+	  char *outputName = argv[7];
+	  int bandRows = argc == 9 ? atoi(argv[8]) : 512;
+
+	  if(operation != "stretch" && operation != "equalize") {
+	    cerr << " operation must be stretch or equalize" << endl;
+	    return(-1);
+	  }
+	  if(w1<0 || h1<0 || w2<=w1 || h2<=h1 || w2>1 || h2>1) {
+	    cerr << " arguments must satisfy 0 <= w1 < w2 <= 1"
+		 << " ,  0 <= h1 < h2 <= 1" << endl;
+	    return(-1);
+	  }
+	  if(bandRows <= 0) {
+	    cerr << " band rows must be positive" << endl;
+	    return(-1);
+	  }
+
+	  //Both images stay on disk, only one band of rows is held at a time
+	  PPMBandSource input(inputName);
+	  if(!input.isOpen()) return(-1);
+	  PPMBandSink output(outputName);
+
+	  cout << "Streaming " << input.cols() << "x" << input.rows()
+	       << " image in bands of " << bandRows << " rows." << endl;
+
+	  int64 start = getTickCount();
+	  bool done = operation == "stretch"
+		  ? WindowStretchLuvStream(input, output, w1, w2, h1, h2, bandRows)
+		  : LequLuvStream(input, output, w1, w2, h1, h2, bandRows);
+	  if(!done) {
+	    cout << "Could not stream " << inputName << " to " << outputName << endl;
+	    return(-1);
+	  }
+	  cout << "Completed in " << (getTickCount()-start)/getTickFrequency() << " s." << endl;
+
+return(0);
+}
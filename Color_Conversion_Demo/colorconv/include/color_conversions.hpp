@@ -0,0 +1,383 @@
+/* MIT License
+ 
+ Copyright (c) 2019 Shane Zabel 
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ =============================================================================
+
+ Implementation of various color conversion algorithms using OpenCV 
+*/
+
+#include <opencv2/opencv.hpp>
+#include <opencv2/highgui.hpp>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+#ifndef COLOR_CONVERSIONS_HPP_
+#define COLOR_CONVERSIONS_HPP_
+
+//Planar 3 channel float image with each channel in its own CV_32FC1 or CV_16FC1 plane, so single channel
+//operations read and write one unit-stride plane and untouched planes are shared between images
+//without copying, the same way Mat headers share data. Each plane is allocated by OpenCV on an
+//aligned address. cv::split(image, planar.planes) and cv::merge(planar.planes, 3, image)
+//convert to and from interleaved images
+struct PlanarImage {
+	Mat planes[3];
+
+	//Function allocates the three planes with the given depth, keeping any that already have this size and depth
+	void create(int rows, int cols, int depth=CV_32F);
+	//Function returns the number of rows
+	int rows() const;
+	//Function returns the number of columns
+	int cols() const;
+	//Function returns true when all three planes are stored continuously
+	bool isContinuous() const;
+};
+
+//Every conversion accepts the same Mat, or planar image, as input and output and then converts
+//in place. Conversions that keep the pixel type reuse the input buffer, conversions that change
+//it release the input buffer once the output is written. Partly overlapping buffers are not supported
+
+//Function selects polynomial approximations instead of pow() in the float gamma, invgamma and cube root paths
+void setUseFastMath(bool enable);
+//Function returns true when the polynomial approximations are selected
+bool useFastMath();
+//Float images may be stored as CV_32FC3 or as half float CV_16FC3, which halves their size and memory
+//traffic. Kernels compute in 32 bit float either way. Conversions to a float color space create
+//their output with the intermediate depth, window and stretch functions keep the depth of their input
+
+//Function selects the depth, CV_32F (default) or CV_16F, of the float images conversions create
+void setIntermediateDepth(int depth);
+//Function returns the depth of the float images conversions create
+int getIntermediateDepth();
+//Function sets the number of threads conversions split their work across, 0 selects COLORCONV_THREADS or the OpenCV default
+void setConversionThreads(int threads);
+//Function sets the number of threads conversions started from the calling thread split their work across, 0 returns to the setting above
+void setThreadConversionThreads(int threads);
+//Function returns the number of threads conversions split their work across
+int getConversionThreads();
+
+//Function takes non-linear scaled [0-255] RGB Mat object reference and updates nonlinear [0-1] RGB Mat object reference
+void nsRGBtonRGB(const Mat& nsRGB, Mat& nRGB);
+//Function takes non-linear [0-1] RGB object reference and returns linear [0-1] RGB object reference
+void nRGBtolRGB(const Mat& nRGB, Mat& lRGB);
+//Function takes non-linear scaled [0-255] RGB Mat object reference and updates linear [0-1] RGB Mat object reference using a lookup table
+void nsRGBtolRGB(const Mat& nsRGB, Mat& lRGB);
+//Function takes linear [0-1] RGB Mat object reference and updates XYZ Mat object reference
+void lRGBtoXYZ(const Mat& lRGB, Mat& XYZ);
+//Function takes an XYZ Mat object reference and updates an xyY Mat object reference
+void XYZtoxyY(const Mat& XYZ, Mat& xyY);
+//Function takes an XYZ Mat object reference and updates an Luv Mat object reference
+void XYZtoLuv(const Mat& XYZ, Mat& Luv);
+//Function takes non-linear scaled [0-255] RGB Mat object reference and updates Luv Mat object reference in a single pass
+void nsRGBtoLuv(const Mat& nsRGB, Mat& Luv);
+//Function takes non-linear scaled [0-255] RGB Mat object reference and updates planar Luv image reference in a single pass
+void nsRGBtoLuv(const Mat& nsRGB, PlanarImage& Luv);
+//Function takes non-linear scaled [0-255] RGB Mat object reference and updates xyY Mat object reference in a single pass
+void nsRGBtoxyY(const Mat& nsRGB, Mat& xyY);
+//Function takes non-linear scaled [0-255] RGB Mat object reference and updates planar xyY image reference in a single pass
+void nsRGBtoxyY(const Mat& nsRGB, PlanarImage& xyY);
+//Function takes Luv Mat object reference and updates stretchLuv Mat object reference with linearly stretched [0-100] L values
+void stretchLuv(const Mat& Luv, Mat& stretchLuv);
+//Function takes planar Luv image reference and updates planar stretchLuv image reference with linearly stretched [0-100] L values
+void stretchLuv(const PlanarImage& Luv, PlanarImage& stretchLuv);
+//Function takes an xyY Mat object reference and updates XYZ Mat object reference
+void xyYtoXYZ(const Mat& xyY, Mat& XYZ);
+//Function takes lan Luv Mat object reference and updates XYZ Mat object reference
+void LuvtoXYZ(const Mat& Luv, Mat& XYZ);
+//Function takes an XYZ Mat object reference and updates a linear RGB Mat object reference
+void XYZtolRGB(const Mat& XYZ, Mat& lRGB);
+//Function takes linear [0-1] RGB Mat object reference and updates XYZ Mat object reference
+void lRGBtonRGB(const Mat& lRGB, Mat& nRGB);
+//Function takes non-linear [0-1] RGB Mat object reference and updates nonlinear scaled [0-255] RGB Mat object reference
+void nRGBtonsRGB(const Mat& nRGB, Mat& nsRGB);
+//Function takes linear [0-1] RGB Mat object reference and updates nonlinear scaled [0-255] RGB Mat object reference using a threshold table
+void lRGBtonsRGB(const Mat& lRGB, Mat& nsRGB);
+//Function takes Luv Mat object reference and updates non-linear scaled [0-255] RGB Mat object reference in a single pass
+void LuvtonsRGB(const Mat& Luv, Mat& nsRGB);
+//Function takes planar Luv image reference and updates non-linear scaled [0-255] RGB Mat object reference in a single pass
+void LuvtonsRGB(const PlanarImage& Luv, Mat& nsRGB);
+//Function takes xyY Mat object reference and updates non-linear scaled [0-255] RGB Mat object reference in a single pass
+void xyYtonsRGB(const Mat& xyY, Mat& nsRGB);
+//Function takes planar xyY image reference and updates non-linear scaled [0-255] RGB Mat object reference in a single pass
+void xyYtonsRGB(const PlanarImage& xyY, Mat& nsRGB);
+//Function takes non-linear scaled [0-255] RGB image and stretches L in Luv domain based on window {h1,w1},{h2,w2}
+void WindowStretchLuv(const Mat& Luv, Mat& stretchLuv, double w1, double w2, double h1, double h2);
+//Function takes planar Luv image and stretches the L plane based on window {h1,w1},{h2,w2}
+void WindowStretchLuv(const PlanarImage& Luv, PlanarImage& stretchLuv, double w1, double w2, double h1, double h2);
+//Function takes xyY image and stretches Y [0.0-1.0] in xyY domain based on window {h1,w1},{h2,w2}
+void WindowStretchxyY(const Mat& xyY, Mat& stretchxyY, double w1, double w2, double h1, double h2);
+//Function takes planar xyY image and stretches the Y plane based on window {h1,w1},{h2,w2}
+void WindowStretchxyY(const PlanarImage& xyY, PlanarImage& stretchxyY, double w1, double w2, double h1, double h2);
+//Function takes Luv image and histogram equalizes L [0.0-100.0] in Luv domain based on window {h1,w1},{h2,w2}
+void LequLuv(const Mat& Luv, Mat& equLuv, double w1, double w2, double h1, double h2);
+//Function takes planar Luv image and histogram equalizes the L plane based on window {h1,w1},{h2,w2}
+void LequLuv(const PlanarImage& Luv, PlanarImage& equLuv, double w1, double w2, double h1, double h2);
+//Function takes Luv image and equalizes L [0.0-100.0] with contrast limited adaptive histogram equalization over a tilesX x tilesY grid,
+//clipLimit caps each tile histogram bin at clipLimit times the mean bin count (0 for no clipping)
+void AdaptiveLequLuv(const Mat& Luv, Mat& equLuv, int tilesX, int tilesY, double clipLimit);
+//Function takes Luv image and updates non-linear scaled [0-255] RGB Mat object reference with L adaptively equalized, in a single pass
+void AdaptiveLequLuvtonsRGB(const Mat& Luv, Mat& nsRGB, int tilesX, int tilesY, double clipLimit);
+
+//Precomputed window statistics for interactive stretching. build() reads one channel of a float or
+//fixed point image of one to three channels once and keeps the minimum and maximum of every 32x32 block in a 2-D sparse table
+//over the grid of blocks. minMax() answers any window from four table entries for the whole blocks
+//inside it plus the partial blocks along its sides, so moving the window costs time in proportion to
+//its perimeter rather than its area. The table shares the pixels of the image, which must not change
+struct MinMaxTable {
+	Mat image;
+	int channel;
+	int blocksX;
+	int blocksY;
+	int levelsX;
+	int levelsY;
+	vector<float> minimum;
+	vector<float> maximum;
+
+	MinMaxTable();
+	//Function builds the table over one channel of an image, returns false for an unsupported image
+	bool build(const Mat& image, int channel);
+	//Function returns the minimum and maximum of the channel inside a window, 0 for both when the window is empty
+	void minMax(const Rect& window, double* min, double* max) const;
+};
+
+//Function takes Luv image and stretches L based on window {h1,w1},{h2,w2}, the window minimum and maximum come from a table built over L (channel 0)
+void WindowStretchLuv(const Mat& Luv, Mat& stretchLuv, const MinMaxTable& L, double w1, double w2, double h1, double h2);
+//Function takes xyY image and stretches Y based on window {h1,w1},{h2,w2}, the window minimum and maximum come from a table built over Y (channel 2)
+void WindowStretchxyY(const Mat& xyY, Mat& stretchxyY, const MinMaxTable& Y, double w1, double w2, double h1, double h2);
+
+//Window of a batch, in the same (w1,w2,h1,h2) coordinates the single window functions take
+struct StretchWindow {
+	double w1;
+	double w2;
+	double h1;
+	double h2;
+};
+
+//Operation a batch applies to every window: stretch or equalize L in Luv, or stretch Y in xyY
+enum BatchOperation {batchStretchL, batchEqualizeL, batchStretchY};
+
+//Function takes non-linear scaled [0-255] RGB image and a list of windows and updates one non-linear scaled [0-255] RGB output per window,
+//converting the image to Luv or xyY once and running the remaps and return paths of all windows in parallel
+void BatchWindows(const Mat& nsRGB, BatchOperation operation, const vector<StretchWindow>& windows, vector<Mat>& outputs);
+
+//Fixed point pipeline for 8 bit input and output. Fixed point Luv images are CV_16SC3 with L, u and v
+//in steps of 1/128, fixed point xyY images are CV_16UC3 with x, y and Y in steps of 1/32768.
+//Matrices run on 16 bit integer lanes and gamma, cube root and L remaps use lookup tables, so
+//results differ from the float pipeline by a small tolerance that the Accuracy tool reports
+
+//Function takes non-linear scaled [0-255] RGB Mat object reference and updates fixed point Luv Mat object reference
+void nsRGBtoLuvFixed(const Mat& nsRGB, Mat& Luv);
+//Function takes non-linear scaled [0-255] RGB Mat object reference and updates fixed point xyY Mat object reference
+void nsRGBtoxyYFixed(const Mat& nsRGB, Mat& xyY);
+//Function takes fixed point Luv image and stretches L based on window {h1,w1},{h2,w2}
+void WindowStretchLuvFixed(const Mat& Luv, Mat& stretchLuv, double w1, double w2, double h1, double h2);
+//Function takes fixed point xyY image and stretches Y based on window {h1,w1},{h2,w2}
+void WindowStretchxyYFixed(const Mat& xyY, Mat& stretchxyY, double w1, double w2, double h1, double h2);
+//Function takes fixed point Luv image and histogram equalizes L based on window {h1,w1},{h2,w2}
+void LequLuvFixed(const Mat& Luv, Mat& equLuv, double w1, double w2, double h1, double h2);
+//Function takes fixed point Luv Mat object reference and updates non-linear scaled [0-255] RGB Mat object reference
+void LuvFixedtonsRGB(const Mat& Luv, Mat& nsRGB);
+//Function takes fixed point xyY Mat object reference and updates non-linear scaled [0-255] RGB Mat object reference
+void xyYFixedtonsRGB(const Mat& xyY, Mat& nsRGB);
+
+//3D lookup table conversions. Once the window statistics fix the L remap, nsRGB to Luv, the remap and
+//Luv to nsRGB are one pixelwise function of the input color. It is sampled on a 33^3, 65^3 or 129^3
+//lattice, the smallest that meets the error bound, and applied with tetrahedral interpolation.
+//When no lattice meets the bound, or the image is smaller than the lattice, the image is converted directly
+
+//Function sets the error bound, in 8 bit levels, that 99 percent of the checked colors of a 3D lookup table must meet (default 2)
+void setLutErrorBound(double levels);
+//Function returns the error bound of the 3D lookup table conversions
+double getLutErrorBound();
+//Function takes non-linear scaled [0-255] RGB image and stretches L in Luv domain based on window {h1,w1},{h2,w2} through a 3D lookup table
+void WindowStretchLuvLUT(const Mat& nsRGB, Mat& stretchRGB, double w1, double w2, double h1, double h2);
+//Function takes non-linear scaled [0-255] RGB image and histogram equalizes L in Luv domain based on window {h1,w1},{h2,w2} through a 3D lookup table
+void LequLuvLUT(const Mat& nsRGB, Mat& equRGB, double w1, double w2, double h1, double h2);
+
+//Precomputed nsRGB to Luv table for batch jobs. The table file holds the fixed point Luv value of
+//every 24 bit color, about 100 MB. Once a process maps it, nsRGBtoLuv and nsRGBtoLuvFixed read one
+//table entry per pixel, and processes mapping the same file share one copy in the page cache.
+//Float Luv from the table is rounded to the 1/128 steps of fixed point Luv
+
+//Function computes the nsRGB to Luv table and writes it to a file, returns false on failure
+bool writeLuvTable(const string& path);
+//Function maps a table file for nsRGBtoLuv and nsRGBtoLuvFixed, returns false when the file is missing or made for another build
+bool loadLuvTable(const string& path);
+//Function unmaps the table, nsRGB to Luv is computed again
+void unloadLuvTable();
+
+//On-disk cache of forward conversions. While it is on, nsRGBtoLuv and nsRGBtoxyY look for a file keyed
+//by a hash of the input pixels, the color space, the intermediate depth, the fast math and Luv table
+//settings and the white point. A matching file is mapped and copied instead of converting, otherwise
+//the result is written as a raw file the next run can map. Once the files pass the size bound the least
+//recently used are removed
+
+//Function turns the cache on in a directory, keeping at most maxBytes of files, or off for an empty directory. Returns false when the directory can't be used
+bool setConversionCache(const string& directory, size_t maxBytes);
+
+//Color spaces a conversion graph can pass through. nsBGR and nsRGB are CV_8UC3 images,
+//the others are float images stored with the intermediate depth
+enum ColorSpace {SPACE_nsBGR, SPACE_nsRGB, SPACE_nRGB, SPACE_lRGB, SPACE_XYZ, SPACE_xyY, SPACE_Luv};
+
+//Source of the rows of an image, read band by band in any order
+struct BandSource {
+	virtual ~BandSource(){}
+	//Function returns the number of rows of the image
+	virtual int rows() const=0;
+	//Function returns the number of columns of the image
+	virtual int cols() const=0;
+	//Function returns the type of the image
+	virtual int type() const=0;
+	//Function reads count rows starting at row into band, which the caller may overwrite, returns false on failure
+	virtual bool read(int row, int count, Mat& band)=0;
+};
+
+//Sink of the rows of an image, written band by band from the top
+struct BandSink {
+	virtual ~BandSink(){}
+	//Function starts an image of the given size and type, returns false on failure
+	virtual bool begin(int rows, int cols, int type)=0;
+	//Function appends a band of rows, returns false on failure
+	virtual bool write(const Mat& band)=0;
+	//Function finishes the image, returns false when it is incomplete or can't be written
+	virtual bool end()=0;
+};
+
+//Band source reading an image held in memory
+struct MatBandSource : BandSource {
+	Mat image;
+
+	MatBandSource(const Mat& source);
+	int rows() const;
+	int cols() const;
+	int type() const;
+	bool read(int row, int count, Mat& band);
+};
+
+//Band sink collecting the bands into an image held in memory
+struct MatBandSink : BandSink {
+	Mat image;
+	int row;
+
+	bool begin(int rows, int cols, int type);
+	bool write(const Mat& band);
+	bool end();
+};
+
+//Band source reading a binary 8 bit PPM (P6) file, whose rows are nsRGB, or PGM (P5) file without loading the whole image
+struct PPMBandSource : BandSource {
+	ifstream file;
+	int width, height, channels;
+	streamoff data;
+
+	PPMBandSource(const string& path);
+	//Function returns true when the file was opened and its header read
+	bool isOpen() const;
+	int rows() const;
+	int cols() const;
+	int type() const;
+	bool read(int row, int count, Mat& band);
+};
+
+//Band sink writing a binary 8 bit PPM (P6) file for CV_8UC3 bands or PGM (P5) file for CV_8UC1 bands as the bands arrive
+struct PPMBandSink : BandSink {
+	ofstream file;
+	string path;
+	int width, height, channels, written;
+
+	PPMBandSink(const string& path);
+	bool begin(int rows, int cols, int type);
+	bool write(const Mat& band);
+	bool end();
+};
+
+//Function writes a CV_8UC3 image to a binary PPM file or a CV_8UC1 image to a binary PGM file row by row, returns false on failure
+bool writeNetpbm(const string& path, const Mat& image);
+
+//Binary PPM or PGM file mapped into memory. image wraps the pixels of the file without copying them,
+//with channels in file order, so PPM images are nsRGB and not BGR as imread returns them. Pages
+//are read when first touched and writes to image stay private to the process. 16 bit pixels the
+//header leaves at an odd offset are copied into an aligned image instead. image is valid
+//until the file is closed or another one is opened
+struct MappedImage {
+	Mat image;
+	void* mapping;
+	size_t bytes;
+
+	MappedImage();
+	~MappedImage();
+	//Function maps a file and wraps its pixels in image, returns false when the file can't be mapped
+	bool open(const string& path);
+	//Function releases image and unmaps the file
+	void close();
+
+	MappedImage(const MappedImage&)=delete;
+	MappedImage& operator=(const MappedImage&)=delete;
+};
+
+//Conversion graph. A chain such as nsBGR -> Luv -> window stretch of L -> nsBGR is described
+//stage by stage and planned when it runs. Conversions expand to the steps between the two spaces,
+//round trips that undo each other are dropped (so only the 8 bit quantization of a trip through
+//nsRGB is kept), R and B swaps are folded into a neighbouring matrix or into the 8 bit load and
+//store, and all remaining steps run as one kernel over blocks of pixels with no intermediate
+//images. Window statistics are taken by running the steps before a window stage over the window only
+struct ConversionGraph {
+	//Kind of a declared stage
+	enum StageKind {convertStage, windowStretchStage, equalizeStage};
+
+	//Declared stage, the window is only used by window stages
+	struct Stage {
+		StageKind kind;
+		ColorSpace space;
+		double w1, w2, h1, h2;
+	};
+
+	ColorSpace input;
+	ColorSpace output;
+	vector<Stage> stages;
+
+	//Function starts a graph whose input images are in the given space
+	ConversionGraph(ColorSpace space);
+	//Function appends a conversion to the given space
+	ConversionGraph& to(ColorSpace space);
+	//Function appends a window stretch of L in Luv or of Y in xyY based on window {h1,w1},{h2,w2}
+	ConversionGraph& windowStretch(double w1, double w2, double h1, double h2);
+	//Function appends a histogram equalization of L in Luv based on window {h1,w1},{h2,w2}
+	ConversionGraph& equalize(double w1, double w2, double h1, double h2);
+	//Function returns a description of the planned passes, one line per pass
+	string plan() const;
+	//Function runs the graph from an input image to an output image, which may be the same Mat
+	void run(const Mat& inputImage, Mat& outputImage) const;
+	//Function runs the graph from a band source to a band sink bandRows rows at a time, so memory depends on
+	//the band size and not on the image size. Window statistics are taken in a first pass over the window rows
+	bool stream(BandSource& source, BandSink& sink, int bandRows) const;
+};
+
+//Function streams a non-linear scaled [0-255] RGB image and stretches L in Luv domain based on window {h1,w1},{h2,w2}, bandRows rows at a time
+bool WindowStretchLuvStream(BandSource& nsRGB, BandSink& stretchRGB, double w1, double w2, double h1, double h2, int bandRows);
+//Function streams a non-linear scaled [0-255] RGB image and histogram equalizes L in Luv domain based on window {h1,w1},{h2,w2}, bandRows rows at a time
+bool LequLuvStream(BandSource& nsRGB, BandSink& equRGB, double w1, double w2, double h1, double h2, int bandRows);
+
+#endif /* COLOR_CONVERSIONS_HPP_ */
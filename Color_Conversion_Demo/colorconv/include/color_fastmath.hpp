@@ -0,0 +1,120 @@
+/* MIT License
+ 
+ Copyright (c) 2019 Shane Zabel 
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ =============================================================================
+
+ Polynomial approximations of the powers used by sRGB gamma and CIE L*.
+ The functions avoid branches and tables so loops calling them can be vectorized
+*/
+
+#ifndef COLOR_FASTMATH_HPP_
+#define COLOR_FASTMATH_HPP_
+
+#include <cstring>
+#include <stdint.h>
+
+//Function returns a when c is true and b otherwise.
+//The choice is made on the bit patterns so that neither value is moved into a branch,
+//which would stop the compiler from vectorizing the calling loop
+static inline float fastSelect(bool c, float a, float b){
+	int32_t abits, bbits;
+	int32_t mask=-(int32_t)c;
+	memcpy(&abits, &a, sizeof(abits));
+	memcpy(&bbits, &b, sizeof(bbits));
+	abits=(abits&mask)|(bbits&~mask);
+	memcpy(&a, &abits, sizeof(a));
+	return a;
+}
+
+//Function computes log2 of a positive normal float.
+//Subtracting the bits of 0.75 splits x into an exponent e and a mantissa m in [0.75,1.5)
+//without a branch, and log2(m) is evaluated as r times a degree 7 polynomial in r=m-1
+//fitted at Chebyshev nodes on [-0.25,0.5).
+//Maximum absolute error is 3.9e-7 for x in [2^-8,1] and 4.0e-6 over all positive normal floats,
+//where rounding of the exponent sum dominates
+static inline float fastLog2(float x){
+	int32_t bits;
+	memcpy(&bits, &x, sizeof(bits));
+	int32_t e=(bits-0x3f400000)>>23;
+	bits=bits-(e<<23);
+	float m;
+	memcpy(&m, &bits, sizeof(m));
+
+	float r=m-1.0f;
+	float p=-0.0938960967f;
+	p=p*r+0.202076588f;
+	p=p*r-0.250414432f;
+	p=p*r+0.290264516f;
+	p=p*r-0.360368292f;
+	p=p*r+0.480842665f;
+	p=p*r-0.721350080f;
+	p=p*r+1.44269527f;
+	return (float)e+r*p;
+}
+
+//Function computes 2^y for y up to 127, results below 2^-126 are not accurate but stay below 2^-125.
+//Adding and subtracting 1.5*2^23 rounds y to the nearest integer n, 2^f for f=y-n in [-0.5,0.5]
+//comes from a degree 6 polynomial fitted at Chebyshev nodes and n is added to the exponent bits.
+//Maximum relative error is 9.6e-8 for y in [-126,127]
+static inline float fastExp2(float y){
+	const float round=12582912.0f;
+	float n=(y+round)-round;
+	float f=y-n;
+
+	float p=0.000154614447f;
+	p=p*f+0.00134004282f;
+	p=p*f+0.00961805668f;
+	p=p*f+0.0555032723f;
+	p=p*f+0.240226509f;
+	p=p*f+0.693147207f;
+	p=p*f+1.0f;
+
+	int32_t bits;
+	int32_t exponent=(int32_t)n;
+	exponent=(exponent<-126) ? -126 : exponent;
+	memcpy(&bits, &p, sizeof(bits));
+	bits+=exponent<<23;
+	memcpy(&p, &bits, sizeof(p));
+	return p;
+}
+
+//Function computes x^2.4 for x in (0,1], the power used by inverse sRGB gamma.
+//Maximum relative error against pow() is 9.9e-7 for x in [0.0894,1], the range used by
+//nRGBtolRGB, results below 2^-126 for x below about 2^-52 are not accurate
+static inline float fastPow2_4(float x){
+	return fastExp2(2.4f*fastLog2(x));
+}
+
+//Function computes x^(1/2.4) for x in (0,1], the power used by sRGB gamma.
+//Maximum relative error against pow() is 3.4e-7 for x in [0.00304,1], the range used by
+//lRGBtonRGB, and 6.6e-7 over (0,1]
+static inline float fastPow1_2_4(float x){
+	return fastExp2(0.416666667f*fastLog2(x));
+}
+
+//Function computes the cube root of x for x in (0,1], used for CIE L*.
+//Maximum relative error against pow(x,1.0/3.0) is 2.2e-7 for x in [0.008856,1], the range
+//used by XYZtoLuv, and 2.2e-6 over (0,1]
+static inline float fastCbrt(float x){
+	return fastExp2(0.333333333f*fastLog2(x));
+}
+
+#endif /* COLOR_FASTMATH_HPP_ */
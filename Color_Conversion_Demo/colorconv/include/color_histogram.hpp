@@ -0,0 +1,155 @@
+/* MIT License
+ 
+ Copyright (c) 2019 Shane Zabel 
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ =============================================================================
+
+ Parallel histograms of one channel of an image inside a window. Each stripe of rows counts
+ into its own histogram, kept as several interleaved copies so neighbouring pixels with the
+ same value don't wait on each other's increments, and the copies are summed at the end
+*/
+
+#ifndef COLOR_HISTOGRAM_HPP_
+#define COLOR_HISTOGRAM_HPP_
+
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+#include <vector>
+
+//Number of interleaved copies of the histogram each stripe counts into, pixel i goes to copy i%histogramCopies
+static const int histogramCopies=4;
+
+//Smallest number of pixels worth a stripe, and a thread, of its own
+static const int histogramStripePixels=1<<16;
+
+//Function returns the number of stripes to cut the rows of a window into, one per thread but none
+//smaller than histogramStripePixels. threads 0 selects the OpenCV thread count, as the header doesn't
+//link the color conversions; their callers pass getConversionThreads() to follow its settings
+static inline int histogramStripes(const cv::Rect& window, int threads=0){
+	double pixels=(double)window.width*window.height;
+	if(threads<=0) threads=cv::getNumThreads();
+	int stripes=(int)std::min((double)threads, pixels/histogramStripePixels);
+	return std::max(std::min(stripes, window.height), 1);
+}
+
+//Function returns the distance between the interleaved copies of a histogram of the given
+//number of bins, rounded up to a whole number of 64 byte cache lines
+static inline int histogramStride(int bins){
+	return (bins+15)&~15;
+}
+
+//Function counts count values, channels apart, into the interleaved copies of a histogram.
+//bin(value) returns the bin of a value
+template<typename T, typename Bin>
+static inline void binValues(const T* values, int count, int channels, int stride, Bin bin, unsigned* copies){
+	unsigned* copy0=copies;
+	unsigned* copy1=copies+stride;
+	unsigned* copy2=copies+2*stride;
+	unsigned* copy3=copies+3*stride;
+	int i=0;
+
+	for( ; i+4 <= count ; i += 4){
+		copy0[bin(values[i*channels])]++;
+		copy1[bin(values[(i+1)*channels])]++;
+		copy2[bin(values[(i+2)*channels])]++;
+		copy3[bin(values[(i+3)*channels])]++;
+	}
+	for( ; i < count ; i++) copy0[bin(values[i*channels])]++;
+}
+
+//Function splits rows [0,rows) into stripes, lets binRow(row, copies) count each row into the
+//interleaved copies of its stripe's histogram, and adds the copies of every stripe to hist in
+//stripe order. Stripes run in parallel through cv::parallel_for_ when there is more than one
+template<typename BinRow>
+static inline void parallelHistogram(int rows, int stripes, int bins, BinRow binRow, int* hist){
+	int stride=histogramStride(bins);
+	size_t stripeSize=(size_t)histogramCopies*stride;
+	std::vector<unsigned> counters(std::max(stripes, 1)*stripeSize, 0);
+
+	auto countStripe=[&](int s){
+		int start=(int)((int64_t)rows*s/stripes);
+		int end=(int)((int64_t)rows*(s+1)/stripes);
+		for(int j = start ; j < end ; j++) binRow(j, &counters[s*stripeSize]);
+	};
+	if(stripes<=1){
+		stripes=1;
+		countStripe(0);
+	}else{
+		cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range& range){
+			for(int s = range.start ; s < range.end ; s++) countStripe(s);
+		}, stripes);
+	}
+
+	for(int s = 0 ; s < stripes ; s++){
+		for(int c = 0 ; c < histogramCopies ; c++){
+			const unsigned* copy=&counters[s*stripeSize+c*stride];
+			for(int b = 0 ; b < bins ; b++) hist[b]+=copy[b];
+		}
+	}
+}
+
+//Function adds the 256 bin histogram of one channel of a CV_8U image inside a window to hist,
+//split across the given number of threads, 0 for the OpenCV thread count
+static inline void histogram8U(const cv::Mat& image, int channel, const cv::Rect& window, int hist[256], int threads=0){
+	int channels=image.channels();
+
+	parallelHistogram(window.height, histogramStripes(window, threads), 256, [&](int row, unsigned* copies){
+		const uchar* values=image.ptr<uchar>(window.y+row)+window.x*channels+channel;
+		binValues(values, window.width, channels, histogramStride(256), [](uchar value){ return (int)value; }, copies);
+	}, hist);
+}
+
+//Function adds the histogram of one channel of a CV_16U image inside a window to hist,
+//in 65536>>shift bins of 1<<shift values each, split across the given number of threads, 0 for the OpenCV thread count
+static inline void histogram16U(const cv::Mat& image, int channel, const cv::Rect& window, int shift, int* hist, int threads=0){
+	int channels=image.channels();
+	int bins=65536>>shift;
+
+	parallelHistogram(window.height, histogramStripes(window, threads), bins, [&](int row, unsigned* copies){
+		const ushort* values=image.ptr<ushort>(window.y+row)+window.x*channels+channel;
+		binValues(values, window.width, channels, histogramStride(bins), [shift](ushort value){ return value>>shift; }, copies);
+	}, hist);
+}
+
+//Function returns the bin of a float value, floor(value*scale+offset) clamped to [0,bins-1]
+static inline int floatBin(float value, int bins, double scale, double offset){
+	double position=floor(value*scale+offset);
+	if(position<0.0) return 0;
+	if(position>bins-1) return bins-1;
+	return (int)position;
+}
+
+//Function adds the histogram of one channel of a CV_32F image inside a window to hist. Value v
+//goes to bin floor(v*scale+offset), values outside the bins are counted in the first or last bin.
+//The rows are split across the given number of threads, 0 for the OpenCV thread count
+static inline void histogram32F(const cv::Mat& image, int channel, const cv::Rect& window, int bins, double scale, double offset, int* hist, int threads=0){
+	int channels=image.channels();
+
+	parallelHistogram(window.height, histogramStripes(window, threads), bins, [&](int row, unsigned* copies){
+		const float* values=image.ptr<float>(window.y+row)+window.x*channels+channel;
+		binValues(values, window.width, channels, histogramStride(bins), [bins,scale,offset](float value){
+			return floatBin(value, bins, scale, offset);
+		}, copies);
+	}, hist);
+}
+
+#endif /* COLOR_HISTOGRAM_HPP_ */
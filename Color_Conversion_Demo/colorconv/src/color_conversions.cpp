@@ -0,0 +1,4217 @@
+/* MIT License
+ 
+ Copyright (c) 2019 Shane Zabel 
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ =============================================================================
+
+ Implementation of various color conversion algorithms using OpenCV 
+*/
+
+#include <opencv2/opencv.hpp>
+#include <opencv2/highgui.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+#include <iostream>
+#include <limits>
+#include <fstream>
+#include <vector>
+#ifndef _WIN32
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+#include "color_conversions.hpp"
+#include "color_fastmath.hpp"
+#include "color_histogram.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define COLOR_CONVERSIONS_X86_SIMD
+#include <immintrin.h>
+#endif
+
+using namespace cv;
+using namespace std;
+
+//Number of threads set with setConversionThreads, 0 when unset
+static int conversionThreads=0;
+
+//Smallest number of pixels worth handing to a thread of its own
+static const int minStripePixels=1<<15;
+
+//Function sets the number of threads conversions split their work across,
+//0 returns to the COLORCONV_THREADS environment variable or the OpenCV default
+void setConversionThreads(int threads){
+	conversionThreads=(threads>0) ? threads : 0;
+return void();
+}
+
+//Number of threads set with setThreadConversionThreads for conversions started from this thread, 0 when unset
+static thread_local int threadConversionThreads=0;
+
+//Function sets the number of threads conversions started from the calling thread split their work
+//across, ahead of setConversionThreads. 0 returns the calling thread to the library-wide setting
+void setThreadConversionThreads(int threads){
+	threadConversionThreads=(threads>0) ? threads : 0;
+return void();
+}
+
+//Function returns the number of threads conversions split their work across
+int getConversionThreads(){
+	static const char* environment=getenv("COLORCONV_THREADS");
+	static const int environmentThreads=(environment!=NULL) ? atoi(environment) : 0;
+
+	if(threadConversionThreads>0) return threadConversionThreads;
+	if(conversionThreads>0) return conversionThreads;
+	if(environmentThreads>0) return environmentThreads;
+	return std::max(getNumThreads(), 1);
+}
+
+//Function returns the number of stripes to cut a run of pixels into,
+//one per thread but none smaller than minStripePixels
+static int stripeCount(double pixels){
+	int stripes=(int)std::min((double)getConversionThreads(), pixels/minStripePixels);
+	return std::max(stripes, 1);
+}
+
+//Function splits [0,n) into the given number of stripes and calls body(stripe,start,end)
+//for each of them, in parallel through cv::parallel_for_ when there is more than one.
+//Stripes are contiguous and cover [0,n) in order, so per-stripe results can be combined
+//in stripe order to get exactly what a serial loop would
+template<typename Body>
+static void forEachStripe(int n, int stripes, Body body){
+	if(stripes<=1){
+		body(0, 0, n);
+		return void();
+	}
+	parallel_for_(Range(0, stripes), [&](const Range& range){
+		for(int s = range.start ; s < range.end ; s++){
+			body(s, (int)((int64)n*s/stripes), (int)((int64)n*(s+1)/stripes));
+		}
+	}, stripes);
+return void();
+}
+
+//Function calls body(row,offset,count) for runs of pixels covering a height x width image.
+//Rows are walked in memory order, and images stored continuously are treated as a single
+//long row so the inner loop runs over the whole buffer.
+//The rows, or the pixels of the single long row, are split into stripes run on separate threads
+template<typename Body>
+static void forEachRun(int height, int width, bool continuous, Body body){
+	if(continuous){
+		width=width*height;
+		height=1;
+	}
+
+	int stripes=stripeCount((double)width*height);
+	if(height==1){
+		forEachStripe(width, stripes, [&](int, int start, int end){
+			body(0, start, end-start);
+		});
+	}else{
+		forEachStripe(height, std::min(stripes, height), [&](int, int start, int end){
+			for(int j = start ; j < end ; j++){
+				body(j, 0, width);
+			}
+		});
+	}
+return void();
+}
+
+//Number of pixels fused kernels push through each stage at a time, small enough
+//for the intermediate block to stay in the L1 cache. Half float images are
+//converted to and from 32 bit float in blocks of the same size
+static const int blockSize=512;
+
+//Depth of the float images conversions create, CV_32F or CV_16F
+static int intermediateDepth=CV_32F;
+
+//Function selects the depth of the float images conversions create, CV_32F or CV_16F.
+//Kernels always compute in 32 bit float, CV_16F images are only a storage format
+void setIntermediateDepth(int depth){
+	if(depth!=CV_32F && depth!=CV_16F){
+		cout << "WARNING: Intermediate depth is not CV_32F or CV_16F." << endl;
+		return void();
+	}
+	intermediateDepth=depth;
+return void();
+}
+
+//Function returns the depth of the float images conversions create
+int getIntermediateDepth(){
+	return intermediateDepth;
+}
+
+//Function converts a 16 bit half float to a 32 bit float
+static inline float halfToFloat(ushort half){
+	uint32_t bits=(uint32_t)(half&0x7fff)<<13;
+	uint32_t exponent=bits&(0x7c00<<13);
+	float value;
+
+	//Move the exponent from bias 15 to bias 127
+	bits+=(uint32_t)(127-15)<<23;
+	if(exponent==(0x7c00<<13)){
+		//Infinity and NaN keep an all ones exponent
+		bits+=(uint32_t)(128-16)<<23;
+		memcpy(&value, &bits, sizeof(value));
+	}else if(exponent==0){
+		//Zero and subnormals are renormalized by subtracting the implicit one, 2^-14
+		bits+=1<<23;
+		memcpy(&value, &bits, sizeof(value));
+		value-=6.103515625e-05f;
+	}else{
+		memcpy(&value, &bits, sizeof(value));
+	}
+	if(half&0x8000) value=-value;
+return value;
+}
+
+//Function converts a 32 bit float to a 16 bit half float, rounding to nearest even like F16C
+static inline ushort floatToHalf(float value){
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	ushort sign=(bits>>16)&0x8000;
+	ushort half;
+
+	bits&=0x7fffffff;
+	if(bits>=(uint32_t)(127+16)<<23){
+		//Too large for a half float, NaN stays a quiet NaN with the top of its payload
+		half=(bits>0x7f800000) ? (0x7e00|((bits>>13)&0x3ff)) : 0x7c00;
+	}else if(bits<(uint32_t)(127-14)<<23){
+		//Subnormal results, adding 0.5 lets the float unit round the mantissa
+		float magnitude;
+		memcpy(&magnitude, &bits, sizeof(magnitude));
+		magnitude+=0.5f;
+		memcpy(&bits, &magnitude, sizeof(bits));
+		half=(ushort)(bits-0x3f000000);
+	}else{
+		//Move the exponent from bias 127 to bias 15 and round the mantissa to nearest even
+		bits+=((uint32_t)(15-127)<<23)+0xfff+((bits>>13)&1);
+		half=(ushort)(bits>>13);
+	}
+return half|sign;
+}
+
+//Function converts n half floats to 32 bit floats
+static void halfToFloatRowScalar(const ushort* input, float* output, int n){
+	for(int i = 0 ; i < n ; i++) output[i]=halfToFloat(input[i]);
+}
+
+//Function converts n 32 bit floats to half floats
+static void floatToHalfRowScalar(const float* input, ushort* output, int n){
+	for(int i = 0 ; i < n ; i++) output[i]=floatToHalf(input[i]);
+}
+
+#ifdef COLOR_CONVERSIONS_X86_SIMD
+//F16C version of halfToFloatRowScalar, 8 values per iteration
+__attribute__((target("avx,f16c")))
+static void halfToFloatRowF16C(const ushort* input, float* output, int n){
+	int i=0;
+
+	for( ; i+8 <= n ; i+=8){
+		_mm256_storeu_ps(output+i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(input+i))));
+	}
+	halfToFloatRowScalar(input+i, output+i, n-i);
+}
+
+//F16C version of floatToHalfRowScalar, 8 values per iteration
+__attribute__((target("avx,f16c")))
+static void floatToHalfRowF16C(const float* input, ushort* output, int n){
+	int i=0;
+
+	for( ; i+8 <= n ; i+=8){
+		_mm_storeu_si128((__m128i*)(output+i), _mm256_cvtps_ph(_mm256_loadu_ps(input+i), _MM_FROUND_TO_NEAREST_INT));
+	}
+	floatToHalfRowScalar(input+i, output+i, n-i);
+}
+#endif
+
+typedef void (*HalfToFloatFunc)(const ushort* input, float* output, int n);
+typedef void (*FloatToHalfFunc)(const float* input, ushort* output, int n);
+
+//Function returns true when the CPU running the program has the F16C conversions
+static bool hasF16C(){
+#ifdef COLOR_CONVERSIONS_X86_SIMD
+	static const bool f16c=checkHardwareSupport(CV_CPU_AVX) && checkHardwareSupport(CV_CPU_FP16);
+	return f16c;
+#else
+	return false;
+#endif
+}
+
+//Function returns the half to float row kernel for the CPU running the program
+static HalfToFloatFunc halfToFloatRow(){
+#ifdef COLOR_CONVERSIONS_X86_SIMD
+	if(hasF16C()) return halfToFloatRowF16C;
+#endif
+	return halfToFloatRowScalar;
+}
+
+//Function returns the float to half row kernel for the CPU running the program
+static FloatToHalfFunc floatToHalfRow(){
+#ifdef COLOR_CONVERSIONS_X86_SIMD
+	if(hasF16C()) return floatToHalfRowF16C;
+#endif
+	return floatToHalfRowScalar;
+}
+
+//Function returns the Mat type conversions create for images of pixel type T,
+//float pixels are stored with the intermediate depth
+template<typename T>
+static int storageType(){
+	if(DataType<T>::depth==CV_32F) return CV_MAKETYPE(intermediateDepth, DataType<T>::channels);
+	return DataType<T>::type;
+}
+
+//Steps per unit of the fixed point images, CV_16S images hold fixed point Luv
+//and CV_16U images hold fixed point xyY
+static const int LuvFixedOne=128;
+static const int xyYFixedOne=32768;
+
+//Function returns a pointer to count pixels of a float image starting at column x of a row,
+//as 32 bit floats. CV_32F images are read in place, CV_16F images are converted into
+//the buffer, which must hold count pixels. Fixed point images are converted into the
+//buffer as the float values they stand for
+static const float* floatPixels(const Mat& image, int row, int x, int count, float* buffer){
+	int channels=image.channels();
+
+	if(image.depth()==CV_16S){
+		const short* pixels=image.ptr<short>(row)+x*channels;
+		for(int i = 0 ; i < count*channels ; i++) buffer[i]=pixels[i]*(1.0f/LuvFixedOne);
+		return buffer;
+	}
+	if(image.depth()==CV_16U){
+		const ushort* pixels=image.ptr<ushort>(row)+x*channels;
+		for(int i = 0 ; i < count*channels ; i++) buffer[i]=pixels[i]*(1.0f/xyYFixedOne);
+		return buffer;
+	}
+	if(image.depth()!=CV_16F) return image.ptr<float>(row)+x*channels;
+	halfToFloatRow()(image.ptr<ushort>(row)+x*channels, buffer, count*channels);
+	return buffer;
+}
+
+//Function applies a row conversion to every row of the input Mat object reference
+//and writes the results to the output Mat object reference.
+//Input and output may be the same Mat, every row conversion reads a pixel before writing it.
+//The input header is copied first so a change of type does not release the input buffer
+//before it is read. The output is created with the given type, float pixels stored as
+//CV_16F on either side go through 32 bit float blocks
+template<typename Tin, typename Tout, typename RowOp>
+static void convertRows(const Mat& input, Mat& output, RowOp op, int type=storageType<Tout>()){
+	Mat source=input;
+	output.create(source.rows, source.cols, type);
+
+	const int inputChannels=DataType<Tin>::channels;
+	const int outputChannels=DataType<Tout>::channels;
+	bool halfInput=DataType<Tin>::depth==CV_32F && source.depth()==CV_16F;
+	bool halfOutput=DataType<Tout>::depth==CV_32F && output.depth()==CV_16F;
+
+	forEachRun(source.rows, source.cols, source.isContinuous() && output.isContinuous(), [&](int j, int x, int n){
+		if(!halfInput && !halfOutput){
+			op(source.ptr<Tin>(j)+x, output.ptr<Tout>(j)+x, n);
+			return void();
+		}
+
+		Tin inputBlock[blockSize];
+		Tout outputBlock[blockSize];
+		for(int start = x ; start < x+n ; start += blockSize){
+			int count = std::min(blockSize, x+n-start);
+			const Tin* in = inputBlock;
+			Tout* out = outputBlock;
+
+			if(halfInput) halfToFloatRow()(source.ptr<ushort>(j)+start*inputChannels, (float*)inputBlock, count*inputChannels);
+			else in = source.ptr<Tin>(j)+start;
+			if(!halfOutput) out = output.ptr<Tout>(j)+start;
+
+			op(in, out, count);
+			if(halfOutput) floatToHalfRow()((const float*)outputBlock, output.ptr<ushort>(j)+start*outputChannels, count*outputChannels);
+		}
+	});
+}
+
+//Function applies a row conversion from an interleaved Mat object reference
+//to the three planes of a PlanarImage object reference
+template<typename Tin, typename RowOp>
+static void convertRowsToPlanar(const Mat& input, PlanarImage& output, RowOp op){
+	output.create(input.rows, input.cols, intermediateDepth);
+	bool halfOutput=intermediateDepth==CV_16F;
+
+	forEachRun(input.rows, input.cols, input.isContinuous() && output.isContinuous(), [&](int j, int x, int n){
+		if(!halfOutput){
+			op(input.ptr<Tin>(j)+x, output.planes[0].ptr<float>(j)+x, output.planes[1].ptr<float>(j)+x,
+			   output.planes[2].ptr<float>(j)+x, n);
+			return void();
+		}
+
+		//Half float planes are written from 32 bit float blocks
+		float blocks[3][blockSize];
+		for(int start = x ; start < x+n ; start += blockSize){
+			int count = std::min(blockSize, x+n-start);
+
+			op(input.ptr<Tin>(j)+start, blocks[0], blocks[1], blocks[2], count);
+			for(int c = 0 ; c < 3 ; c++) floatToHalfRow()(blocks[c], output.planes[c].ptr<ushort>(j)+start, count);
+		}
+	});
+}
+
+//Function applies a row conversion from the three planes of a PlanarImage object reference
+//to an interleaved Mat object reference
+template<typename Tout, typename RowOp>
+static void convertRowsFromPlanar(const PlanarImage& input, Mat& output, RowOp op){
+	output.create(input.rows(), input.cols(), DataType<Tout>::type);
+	bool halfInput=input.planes[0].depth()==CV_16F;
+
+	forEachRun(input.rows(), input.cols(), input.isContinuous() && output.isContinuous(), [&](int j, int x, int n){
+		if(!halfInput){
+			op(input.planes[0].ptr<float>(j)+x, input.planes[1].ptr<float>(j)+x, input.planes[2].ptr<float>(j)+x,
+			   output.ptr<Tout>(j)+x, n);
+			return void();
+		}
+
+		//Half float planes are read into 32 bit float blocks
+		float blocks[3][blockSize];
+		for(int start = x ; start < x+n ; start += blockSize){
+			int count = std::min(blockSize, x+n-start);
+
+			for(int c = 0 ; c < 3 ; c++) halfToFloatRow()(input.planes[c].ptr<ushort>(j)+start, blocks[c], count);
+			op(blocks[0], blocks[1], blocks[2], output.ptr<Tout>(j)+start, count);
+		}
+	});
+}
+
+//Function finds the minimum and maximum of one channel of a float image inside a window
+//like minMaxLoc, the window rows are split into stripes run on separate threads.
+//The image may have one to three channels, so both interleaved images and planes are accepted, as the
+//block buffer holds three values per pixel, and may be CV_32F, CV_16F or fixed point. The window is
+//clipped to the image as MinMaxTable::minMax does
+static void windowMinMax(const Mat& image, int channel, const Rect& requested, double* min, double* max){
+	const float infinity=numeric_limits<float>::infinity();
+	Rect window=requested & Rect(0, 0, image.cols, image.rows);
+	int stripes=std::min(stripeCount((double)window.width*window.height), std::max(window.height, 1));
+	vector<float> stripeMin(stripes, infinity);
+	vector<float> stripeMax(stripes, -infinity);
+
+	int channels=image.channels();
+
+	forEachStripe(window.height, stripes, [&](int s, int start, int end){
+		float low=infinity;
+		float high=-infinity;
+		float buffer[3*blockSize];
+
+		for(int j = start ; j < end ; j++){
+			for(int x = 0 ; x < window.width ; x += blockSize){
+				int count=std::min(blockSize, window.width-x);
+				const float* row=floatPixels(image, window.y+j, window.x+x, count, buffer)+channel;
+				for(int i = 0 ; i < count ; i++){
+					float value=row[i*channels];
+					if(value<low) low=value;
+					if(value>high) high=value;
+				}
+			}
+		}
+		stripeMin[s]=low;
+		stripeMax[s]=high;
+	});
+
+	float low=infinity;
+	float high=-infinity;
+	for(int s = 0 ; s < stripes ; s++){
+		if(stripeMin[s]<low) low=stripeMin[s];
+		if(stripeMax[s]>high) high=stripeMax[s];
+	}
+
+	//An empty window gives 0 for both, as minMaxLoc does
+	if(low>high){
+		low=0.0f;
+		high=0.0f;
+	}
+	*min=low;
+	*max=high;
+return void();
+}
+
+//Function adds the histogram of one [0-100] channel of a float image inside a window to hist.
+//Values are rounded to the nearest integer and each stripe of window rows fills its own
+//histogram, the stripes are summed in order. By default the window is cut into one stripe
+//per conversion thread. The image may have one to three channels, as windowMinMax
+static void accumulateHistogram(const Mat& image, int channel, const Rect& window, int hist[101], int stripes=0){
+	int channels=image.channels();
+	if(stripes<=0) stripes=std::min(stripeCount((double)window.width*window.height), std::max(window.height, 1));
+
+	//Discretize the channel in the window to the nearest integer and count it through the parallel
+	//histogram engine, values past either end of [0,100] are counted in the end bins
+	parallelHistogram(window.height, stripes, 101, [&](int i, unsigned* copies){
+		float buffer[3*blockSize];
+		for(int x = 0 ; x < window.width ; x += blockSize){
+			int count=std::min(blockSize, window.width-x);
+			const float* row=floatPixels(image, window.y+i, window.x+x, count, buffer)+channel;
+			binValues(row, count, channels, histogramStride(101), [](float value){
+				return floatBin(value, 101, 1.0, 0.5);
+			}, copies);
+		}
+	}, hist);
+return void();
+}
+
+//Function builds the histogram equalization map of a window of the given area from its histogram
+static void equalizationMapFromHistogram(const int hist[101], int area, int pix_map[101]){
+	//A window outside the image has no values to equalize by and leaves them unchanged
+	if(area<=0){
+		for(int i=0 ; i<101 ; i++) pix_map[i]=i;
+		return void();
+	}
+
+	//Compute the sum_hist
+	int accum=0;
+	int sum_hist[101];
+	for(int i=0 ; i<101 ; i++){
+		accum+=hist[i];
+		sum_hist[i]=accum;
+	}
+
+	//Create the mapping
+	pix_map[0]=(int)floor( ((0+sum_hist[0])/2.0)*(100.0/area) );
+	for(int i=1 ; i<101 ; i++){
+		pix_map[i]=(int)floor( ((sum_hist[i-1]+sum_hist[i])/2.0)*(100.0/area) );
+	}
+return void();
+}
+
+//Function builds the histogram equalization map of one [0-100] channel of a float image
+//from the values inside a window
+static void equalizationMap(const Mat& image, int channel, const Rect& window, int pix_map[101]){
+	int hist[101];
+	for(int k = 0 ; k < 101 ; k++) hist[k] = 0;
+
+	accumulateHistogram(image, channel, window, hist);
+	equalizationMapFromHistogram(hist, window.width*window.height, pix_map);
+return void();
+}
+
+//Function applies a per-pixel conversion to every pixel of the input Mat object reference
+//and writes the results to the output Mat object reference
+template<typename Tin, typename Tout, typename PixelOp>
+static void convertPixels(const Mat& input, Mat& output, PixelOp op, int type=storageType<Tout>()){
+	convertRows<Tin,Tout>(input, output, [&op](const Tin* inputRow, Tout* outputRow, int n){
+		for(int i = 0 ; i < n ; i++){
+			outputRow[i]=op(inputRow[i]);
+		}
+	}, type);
+}
+
+//Function allocates the three planes with the given depth, CV_32F or CV_16F,
+//keeping any that already have this size and depth
+void PlanarImage::create(int rows, int cols, int depth){
+	for(int c = 0 ; c < 3 ; c++) planes[c].create(rows, cols, CV_MAKETYPE(depth,1));
+return void();
+}
+
+//Function returns the number of rows
+int PlanarImage::rows() const{
+	return planes[0].rows;
+}
+
+//Function returns the number of columns
+int PlanarImage::cols() const{
+	return planes[0].cols;
+}
+
+//Function returns true when all three planes are stored continuously
+bool PlanarImage::isContinuous() const{
+	return planes[0].isContinuous() && planes[1].isContinuous() && planes[2].isContinuous();
+}
+
+//Function returns true when a planar image has three CV_32FC1 or three CV_16FC1 planes of equal size
+//and prints a warning naming the image otherwise
+static bool checkPlanar(const PlanarImage& image, const char* name){
+	for(int c = 0 ; c < 3 ; c++){
+		if(image.planes[c].type()!=image.planes[0].type() || image.planes[c].size()!=image.planes[0].size()){
+			cout << "WARNING: Input " << name << " planar image is not three CV_32FC1 or CV_16FC1 planes of equal size." << endl;
+			return false;
+		}
+	}
+	if(image.planes[0].type()!=CV_32FC1 && image.planes[0].type()!=CV_16FC1){
+		cout << "WARNING: Input " << name << " planar image is not three CV_32FC1 or CV_16FC1 planes of equal size." << endl;
+		return false;
+	}
+	return true;
+}
+
+//Function returns true when an image is a 3 channel float image, CV_32FC3 or CV_16FC3
+static bool isFloatImage(const Mat& image){
+	return image.type()==CV_32FC3 || image.type()==CV_16FC3;
+}
+
+//Function returns the plane a single channel operation writes its result to. When input and
+//output are the same image the input plane is overwritten in place, otherwise an empty Mat is
+//returned so a new plane is allocated and planes the output shares with other images are left alone
+static Mat outputPlane(const PlanarImage& input, const PlanarImage& output, int plane){
+	if(&input==&output) return input.planes[plane];
+	return Mat();
+}
+
+//Function copies a block of pixels into three planes
+static inline void scatterBlock(const Vec3f* pixels, float* plane0, float* plane1, float* plane2, int count){
+	for(int i = 0 ; i < count ; i++){
+		plane0[i]=pixels[i][0];
+		plane1[i]=pixels[i][1];
+		plane2[i]=pixels[i][2];
+	}
+}
+
+//Function copies a block of pixels out of three planes
+static inline void gatherBlock(const float* plane0, const float* plane1, const float* plane2, Vec3f* pixels, int count){
+	for(int i = 0 ; i < count ; i++){
+		pixels[i]=Vec3f(plane0[i], plane1[i], plane2[i]);
+	}
+}
+
+//Function converts window coordinates (w1,w2,h1,h2) to a pixel rectangle of an image with the given size.
+//Both directions are scaled by height-1 as the demos always have, and extra is added to the size
+//when the box includes its far corner. On a portrait image the box can reach past the last column,
+//so it is clipped to the image
+static Rect windowRect(Size size, double w1, double w2, double h1, double h2, int extra){
+	int height=size.height;
+	int ih1= (int) (h1*(height-1));
+	int ih2= (int) (h2*(height-1));
+	int iw1= (int) (w1*(height-1));
+	int iw2= (int) (w2*(height-1));
+
+	return Rect(iw1, ih1, (iw2-iw1)+extra, (ih2-ih1)+extra) & Rect(0, 0, size.width, size.height);
+}
+
+//Function linearly stretches a value from [min,max] to [0,scale] and clamps the result
+static inline float stretchValue(float pixel, double min, double max, double scale){
+	float value=(pixel-min)*scale/(max-min);
+	if(value>scale) value=scale;
+	if(value<0.0) value=0.0;
+	return value;
+}
+
+//Function maps a [0-100] value through a histogram equalization map
+static inline float equalizeValue(const int* pix_map, float pixel){
+	return (float)pix_map[(int)floor(pixel)];
+}
+
+//Library-wide switch between pow() and the polynomial approximations in color_fastmath.hpp
+static bool fastMath=false;
+
+//Function selects the polynomial approximations for the float gamma, invgamma and cube root paths
+void setUseFastMath(bool enable){
+	fastMath=enable;
+return void();
+}
+
+//Function returns true when the polynomial approximations are selected
+bool useFastMath(){
+	return fastMath;
+}
+
+//Function applies a curve to every channel of a row of float pixels and clamps the results to [0-1].
+//The row is walked as a flat array of floats so the compiler can vectorize the loop
+template<float (*curve)(float)>
+static void curveRow(const Vec3f* inputRow, Vec3f* outputRow, int n){
+	const float* input=inputRow->val;
+	float* output=outputRow->val;
+
+	for(int i = 0 ; i < 3*n ; i++){
+		float value=curve(input[i]);
+		value=fastSelect(value<0.0f, 0.0f, value);
+		value=fastSelect(value>1.0f, 1.0f, value);
+		output[i]=value;
+	}
+}
+
+//Assume D65 white
+static const float Xw=0.95;
+static const float Yw=1.0;
+static const float Zw=1.09;
+
+//Compute uw and vw
+static const float uw=4.0*Xw/(Xw+15.0*Yw+3.0*Zw);
+static const float vw=9.0*Yw/(Xw+15.0*Yw+3.0*Zw);
+
+//Function converts a single non-linear scaled [0-255] byte RGB pixel
+//to a nonlinear [0-1] float RGB pixel
+static inline Vec3f nsRGBtonRGBPixel(const Vec3b& nsRGBval){
+	Vec3f color;
+
+	uint nsR = nsRGBval[0];
+	uint nsG = nsRGBval[1];
+	uint nsB = nsRGBval[2];
+	float nR,nG,nB;
+
+	nR=nsR/255.0;
+	nG=nsG/255.0;
+	nB=nsB/255.0;
+
+	if(nR<0.0) nR=0.0;
+	if(nG<0.0) nG=0.0;
+	if(nB<0.0) nB=0.0;
+	if(nR>1.0) nR=1.0;
+	if(nG>1.0) nG=1.0;
+	if(nB>1.0) nB=1.0;
+
+	color[0]=nR;
+	color[1]=nG;
+	color[2]=nB;
+	return color;
+}
+
+//Function takes non-linear scaled [0-255] byte (uint) RGB Mat object reference
+//and updates nonlinear [0-1] float RGB Mat object reference
+void nsRGBtonRGB(const Mat& nsRGB, Mat& nRGB){
+	convertPixels<Vec3b,Vec3f>(nsRGB, nRGB, [](const Vec3b& pixel){ return nsRGBtonRGBPixel(pixel); });
+return void();
+}
+
+//Function computes inverse gamma correction of a float
+float invgamma(float v){
+	float answer;
+
+	if(v<0.03928){
+		answer = v/12.92;
+	}else{
+		answer = pow((v+0.055)/1.055,2.4);
+	}
+return answer;
+}
+
+//Function computes inverse gamma correction of a float using fastPow2_4.
+//Both segments are evaluated and one is selected so loops over pixels can be vectorized
+static inline float fastInvgamma(float v){
+	float linear=v/12.92f;
+	float power=fastPow2_4((v+0.055f)/1.055f);
+
+return fastSelect(v<0.03928f, linear, power);
+}
+
+//Function converts a single non-linear [0-1] RGB pixel to a linear [0-1] RGB pixel
+static inline Vec3f nRGBtolRGBPixel(const Vec3f& nRGBval){
+	Vec3f color;
+
+	float nR = nRGBval[0];
+	float nG = nRGBval[1];
+	float nB = nRGBval[2];
+	float lR,lG,lB;
+
+	lR=invgamma(nR);
+	lG=invgamma(nG);
+	lB=invgamma(nB);
+
+	if(lR<0.0) lR=0.0;
+	if(lG<0.0) lG=0.0;
+	if(lB<0.0) lB=0.0;
+	if(lR>1.0) lR=1.0;
+	if(lG>1.0) lG=1.0;
+	if(lB>1.0) lB=1.0;
+
+	color[0]=lR;
+	color[1]=lG;
+	color[2]=lB;
+	return color;
+}
+
+//Function takes non-linear [0-1] RGB object reference
+//and returns linear [0-1] RGB object reference
+void nRGBtolRGB(const Mat& nRGB, Mat& lRGB){
+	if(useFastMath()){
+		convertRows<Vec3f,Vec3f>(nRGB, lRGB, curveRow<fastInvgamma>);
+	}else{
+		convertRows<Vec3f,Vec3f>(nRGB, lRGB, curveRow<invgamma>);
+	}
+return void();
+}
+
+//Table mapping a non-linear scaled [0-255] byte value to its linear [0-1] value.
+//Entries are computed once with nsRGBtonRGBPixel and nRGBtolRGBPixel,
+//so the table gives exactly the same result as the pow() path
+struct InvgammaTable {
+	float value[256];
+
+	InvgammaTable(){
+		for(int k = 0 ; k < 256 ; k++){
+			Vec3b nsRGBval((uchar)k,(uchar)k,(uchar)k);
+			value[k]=nRGBtolRGBPixel(nsRGBtonRGBPixel(nsRGBval))[0];
+		}
+	}
+};
+
+//Function returns the invgamma lookup table, built on first use
+static const float* invgammaTable(){
+	static const InvgammaTable table;
+	return table.value;
+}
+
+//Function converts a single non-linear scaled [0-255] byte RGB pixel
+//to a linear [0-1] float RGB pixel using the invgamma lookup table
+static inline Vec3f nsRGBtolRGBPixel(const float* table, const Vec3b& nsRGBval){
+	Vec3f color;
+
+	color[0]=table[nsRGBval[0]];
+	color[1]=table[nsRGBval[1]];
+	color[2]=table[nsRGBval[2]];
+	return color;
+}
+
+//Function takes non-linear scaled [0-255] byte (uint) RGB Mat object reference
+//and updates linear [0-1] float RGB Mat object reference.
+//Equivalent to nsRGBtonRGB followed by nRGBtolRGB, using a 256 entry lookup table
+void nsRGBtolRGB(const Mat& nsRGB, Mat& lRGB){
+	const float* table=invgammaTable();
+
+	convertPixels<Vec3b,Vec3f>(nsRGB, lRGB, [table](const Vec3b& pixel){ return nsRGBtolRGBPixel(table, pixel); });
+return void();
+}
+
+//Function converts a single linear [0-1] RGB pixel to an XYZ pixel
+static inline Vec3f lRGBtoXYZPixel(const Vec3f& lRGBval){
+	Vec3f color;
+
+	float lR = lRGBval[0];
+	float lG = lRGBval[1];
+	float lB = lRGBval[2];
+	float X,Y,Z;
+
+	X=0.412*lR+0.358*lG+0.180*lB;
+	Y=0.213*lR+0.715*lG+0.072*lB;
+	Z=0.019*lR+0.119*lG+0.950*lB;
+
+	if(X<0.0) X=0.0;
+	if(Y<0.0) Y=0.0;
+	if(Z<0.0) Z=0.0;
+
+	color[0]=X;
+	color[1]=Y;
+	color[2]=Z;
+	return color;
+}
+
+//Coefficients of the linear RGB to XYZ matrix, row major
+static const double lRGBtoXYZMatrix[9]={
+	0.412, 0.358, 0.180,
+	0.213, 0.715, 0.072,
+	0.019, 0.119, 0.950};
+
+//Coefficients of the XYZ to linear RGB matrix, row major
+static const double XYZtolRGBMatrix[9]={
+	3.240479, -1.53715, -0.498535,
+	-0.969256, 1.875991, 0.041556,
+	0.055648, -0.204043, 1.057311};
+
+//Function applies a 3x3 color matrix to a row of n pixels, clamping results below 0
+//and optionally above 1. Products and sums are done in double in the same order as
+//lRGBtoXYZPixel and XYZtolRGBPixel, so every kernel below gives identical results.
+//Input and output may be the same row
+static void matrixRowScalar(const double* m, bool clampOne, const Vec3f* input, Vec3f* output, int n){
+	for(int i = 0 ; i < n ; i++){
+		float R = input[i][0];
+		float G = input[i][1];
+		float B = input[i][2];
+		float X,Y,Z;
+
+		X=m[0]*R+m[1]*G+m[2]*B;
+		Y=m[3]*R+m[4]*G+m[5]*B;
+		Z=m[6]*R+m[7]*G+m[8]*B;
+
+		if(X<0.0) X=0.0;
+		if(Y<0.0) Y=0.0;
+		if(Z<0.0) Z=0.0;
+		if(clampOne){
+			if(X>1.0) X=1.0;
+			if(Y>1.0) Y=1.0;
+			if(Z>1.0) Z=1.0;
+		}
+
+		output[i][0]=X;
+		output[i][1]=Y;
+		output[i][2]=Z;
+	}
+}
+
+#ifdef COLOR_CONVERSIONS_X86_SIMD
+
+//Function splits 4 interleaved pixels held in a, b, c into R, G and B vectors
+__attribute__((target("sse4.1")))
+static inline void deinterleave4(__m128 a, __m128 b, __m128 c, __m128& R, __m128& G, __m128& B){
+	R=_mm_blend_ps(_mm_blend_ps(a, b, 0x4), c, 0x2);
+	G=_mm_blend_ps(_mm_blend_ps(a, b, 0x9), c, 0x4);
+	B=_mm_blend_ps(_mm_blend_ps(a, b, 0x2), c, 0x9);
+	R=_mm_shuffle_ps(R, R, _MM_SHUFFLE(1,2,3,0));
+	G=_mm_shuffle_ps(G, G, _MM_SHUFFLE(2,3,0,1));
+	B=_mm_shuffle_ps(B, B, _MM_SHUFFLE(3,0,1,2));
+}
+
+//Function merges X, Y and Z vectors back into 4 interleaved pixels in a, b, c
+__attribute__((target("sse4.1")))
+static inline void interleave4(__m128 X, __m128 Y, __m128 Z, __m128& a, __m128& b, __m128& c){
+	X=_mm_shuffle_ps(X, X, _MM_SHUFFLE(1,2,3,0));
+	Y=_mm_shuffle_ps(Y, Y, _MM_SHUFFLE(2,3,0,1));
+	Z=_mm_shuffle_ps(Z, Z, _MM_SHUFFLE(3,0,1,2));
+	a=_mm_blend_ps(_mm_blend_ps(X, Y, 0x2), Z, 0x4);
+	b=_mm_blend_ps(_mm_blend_ps(X, Y, 0x9), Z, 0x2);
+	c=_mm_blend_ps(_mm_blend_ps(X, Y, 0x4), Z, 0x9);
+}
+
+//Function clamps a vector the same way as the scalar kernel: max(0,v) keeps -0.0
+//and NaN like "if(v<0.0) v=0.0" does, min(1,v) matches "if(v>1.0) v=1.0"
+__attribute__((target("sse4.1")))
+static inline __m128 clampVector(__m128 v, bool clampOne){
+	v=_mm_max_ps(_mm_setzero_ps(), v);
+	if(clampOne) v=_mm_min_ps(_mm_set1_ps(1.0f), v);
+	return v;
+}
+
+//SSE4.1 version of matrixRowScalar, 4 pixels per iteration in pairs of doubles
+__attribute__((target("sse4.1")))
+static void matrixRowSSE41(const double* m, bool clampOne, const Vec3f* input, Vec3f* output, int n){
+	const float* in=(const float*)input;
+	float* out=(float*)output;
+	int i=0;
+
+	for( ; i+4 <= n ; i+=4, in+=12, out+=12){
+		__m128 R,G,B;
+		deinterleave4(_mm_loadu_ps(in), _mm_loadu_ps(in+4), _mm_loadu_ps(in+8), R, G, B);
+
+		__m128d Rl=_mm_cvtps_pd(R), Rh=_mm_cvtps_pd(_mm_movehl_ps(R, R));
+		__m128d Gl=_mm_cvtps_pd(G), Gh=_mm_cvtps_pd(_mm_movehl_ps(G, G));
+		__m128d Bl=_mm_cvtps_pd(B), Bh=_mm_cvtps_pd(_mm_movehl_ps(B, B));
+
+		__m128 result[3];
+		for(int r = 0 ; r < 3 ; r++){
+			__m128d m0=_mm_set1_pd(m[3*r]), m1=_mm_set1_pd(m[3*r+1]), m2=_mm_set1_pd(m[3*r+2]);
+			__m128d low=_mm_add_pd(_mm_add_pd(_mm_mul_pd(m0, Rl), _mm_mul_pd(m1, Gl)), _mm_mul_pd(m2, Bl));
+			__m128d high=_mm_add_pd(_mm_add_pd(_mm_mul_pd(m0, Rh), _mm_mul_pd(m1, Gh)), _mm_mul_pd(m2, Bh));
+			result[r]=clampVector(_mm_movelh_ps(_mm_cvtpd_ps(low), _mm_cvtpd_ps(high)), clampOne);
+		}
+
+		__m128 a,b,c;
+		interleave4(result[0], result[1], result[2], a, b, c);
+		_mm_storeu_ps(out, a);
+		_mm_storeu_ps(out+4, b);
+		_mm_storeu_ps(out+8, c);
+	}
+	matrixRowScalar(m, clampOne, input+i, output+i, n-i);
+}
+
+//AVX version of matrixRowScalar, 4 pixels per iteration in one vector of doubles
+__attribute__((target("avx")))
+static void matrixRowAVX(const double* m, bool clampOne, const Vec3f* input, Vec3f* output, int n){
+	const float* in=(const float*)input;
+	float* out=(float*)output;
+	int i=0;
+
+	for( ; i+4 <= n ; i+=4, in+=12, out+=12){
+		__m128 R,G,B;
+		deinterleave4(_mm_loadu_ps(in), _mm_loadu_ps(in+4), _mm_loadu_ps(in+8), R, G, B);
+
+		__m256d Rd=_mm256_cvtps_pd(R);
+		__m256d Gd=_mm256_cvtps_pd(G);
+		__m256d Bd=_mm256_cvtps_pd(B);
+
+		__m128 result[3];
+		for(int r = 0 ; r < 3 ; r++){
+			__m256d m0=_mm256_set1_pd(m[3*r]), m1=_mm256_set1_pd(m[3*r+1]), m2=_mm256_set1_pd(m[3*r+2]);
+			__m256d sum=_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(m0, Rd), _mm256_mul_pd(m1, Gd)), _mm256_mul_pd(m2, Bd));
+			result[r]=clampVector(_mm256_cvtpd_ps(sum), clampOne);
+		}
+
+		__m128 a,b,c;
+		interleave4(result[0], result[1], result[2], a, b, c);
+		_mm_storeu_ps(out, a);
+		_mm_storeu_ps(out+4, b);
+		_mm_storeu_ps(out+8, c);
+	}
+	matrixRowScalar(m, clampOne, input+i, output+i, n-i);
+}
+#endif
+
+typedef void (*MatrixRowFunc)(const double* m, bool clampOne, const Vec3f* input, Vec3f* output, int n);
+
+//Function picks the fastest matrix kernel the CPU running the program supports
+static MatrixRowFunc selectMatrixRow(){
+#ifdef COLOR_CONVERSIONS_X86_SIMD
+	if(checkHardwareSupport(CV_CPU_AVX)) return matrixRowAVX;
+	if(checkHardwareSupport(CV_CPU_SSE4_1)) return matrixRowSSE41;
+#endif
+	return matrixRowScalar;
+}
+
+//Function returns the matrix kernel, selected once on first use
+static MatrixRowFunc matrixRow(){
+	static const MatrixRowFunc func=selectMatrixRow();
+	return func;
+}
+
+//Function takes linear [0-1] RGB Mat object reference
+//and updates XYZ Mat object reference
+void lRGBtoXYZ(const Mat& lRGB, Mat& XYZ){
+	MatrixRowFunc matrix=matrixRow();
+
+	convertRows<Vec3f,Vec3f>(lRGB, XYZ, [matrix](const Vec3f* inputRow, Vec3f* outputRow, int n){
+		matrix(lRGBtoXYZMatrix, false, inputRow, outputRow, n);
+	});
+return void();
+}
+
+//Function converts a single XYZ pixel to an xyY pixel
+static inline Vec3f XYZtoxyYPixel(const Vec3f& XYZval){
+	Vec3f color;
+
+	float X = XYZval[0];
+	float Y = XYZval[1];
+	float Z = XYZval[2];
+	float x,y;
+
+	if(X<0.000001 && Y<0.000001 && Z<0.000001){
+		x=0.0;
+		y=0.0;
+		Y=0.0;
+	}else{
+		x=X/(X+Y+Z);
+		y=Y/(X+Y+Z);
+		if(x<0.0) x=0.0;
+		if(y<0.0) y=0.0;
+		if(x>1.0) x=1.0;
+		if(y>1.0) y=1.0;
+		if(Y<0.0) Y=0.0;
+	}
+
+	color[0]=x;
+	color[1]=y;
+	color[2]=Y;
+	return color;
+}
+
+//Function takes an XYZ Mat object reference
+//and updates an xyY Mat object reference
+void XYZtoxyY(const Mat& XYZ, Mat& xyY){
+	convertPixels<Vec3f,Vec3f>(XYZ, xyY, [](const Vec3f& pixel){ return XYZtoxyYPixel(pixel); });
+return void();
+}
+
+//Function computes the cube root of t for CIE L*
+static inline double cubeRoot(float t){
+	return pow(t,1.0/3.0);
+}
+
+//Function computes the cube root of t for CIE L* using fastCbrt
+static inline double fastCubeRoot(float t){
+	return fastCbrt(t);
+}
+
+//Function converts a single XYZ pixel to an Luv pixel using the given cube root
+template<double (*cuberoot)(float)>
+static inline Vec3f XYZtoLuvPixel(const Vec3f& XYZval){
+	Vec3f color;
+
+	float X = XYZval[0];
+	float Y = XYZval[1];
+	float Z = XYZval[2];
+	float L,u,v;
+	float uprime, vprime;
+
+	//Compute t and L
+	float t=Y/Yw;
+	if(t>0.008856){
+		L=116.0*cuberoot(t)-16.0;
+	}else{
+		L=903.3*t;
+	}
+	if(L<0.000001) L=0.0;
+	if(L>100.0) L=100.0;
+
+	//Compute d, uprime and vprime
+	float d=X+15.0*Y+3.0*Z;
+	if(d>0.000001){
+		uprime=4.0*X/d;
+		vprime=9.0*Y/d;
+	}else{
+		uprime=0.0;
+		vprime=0.0;
+	}
+
+	//Compute u and v
+	if(L>0.000001){
+		u=13.0*L*(uprime-uw);
+		v=13.0*L*(vprime-vw);
+	}else{
+		u=0.0;
+		v=0.0;
+	}
+
+	color[0]=L;
+	color[1]=u;
+	color[2]=v;
+	return color;
+}
+
+//Function takes an XYZ Mat object reference
+//and updates an Luv Mat object reference
+void XYZtoLuv(const Mat& XYZ, Mat& Luv){
+	if(useFastMath()){
+		convertPixels<Vec3f,Vec3f>(XYZ, Luv, [](const Vec3f& pixel){ return XYZtoLuvPixel<fastCubeRoot>(pixel); });
+	}else{
+		convertPixels<Vec3f,Vec3f>(XYZ, Luv, [](const Vec3f& pixel){ return XYZtoLuvPixel<cubeRoot>(pixel); });
+	}
+return void();
+}
+
+//Function converts a block of non-linear scaled [0-255] byte RGB pixels to XYZ pixels
+//with the invgamma lookup table and the matrix kernel
+static inline void nsRGBtoXYZBlock(const float* table, MatrixRowFunc matrix, const Vec3b* input, Vec3f* output, int count){
+	for(int i = 0 ; i < count ; i++) output[i]=nsRGBtolRGBPixel(table, input[i]);
+	matrix(lRGBtoXYZMatrix, false, output, output, count);
+}
+
+//Function converts a block of XYZ pixels to Luv pixels in place
+static inline void XYZtoLuvBlock(bool fast, Vec3f* pixels, int count){
+	if(fast){
+		for(int i = 0 ; i < count ; i++) pixels[i]=XYZtoLuvPixel<fastCubeRoot>(pixels[i]);
+	}else{
+		for(int i = 0 ; i < count ; i++) pixels[i]=XYZtoLuvPixel<cubeRoot>(pixels[i]);
+	}
+}
+
+//Function converts a block of XYZ pixels to xyY pixels in place
+static inline void XYZtoxyYBlock(Vec3f* pixels, int count){
+	for(int i = 0 ; i < count ; i++) pixels[i]=XYZtoxyYPixel(pixels[i]);
+}
+
+//Function computes Luv from non-linear scaled [0-255] byte RGB into a Luv image of the given type,
+//with the polynomial approximations when fast is set. The settings are passed in rather than read
+//from the library, so the table builder gets the exact CV_32F result while conversions run
+static void nsRGBtoLuvKernel(const Mat& nsRGB, Mat& Luv, bool fast, int type){
+	const float* table=invgammaTable();
+	MatrixRowFunc matrix=matrixRow();
+
+	//Each block of the output row holds lRGB, then XYZ, then the final Luv values
+	convertRows<Vec3b,Vec3f>(nsRGB, Luv, [table,matrix,fast](const Vec3b* inputRow, Vec3f* outputRow, int n){
+		for(int start = 0 ; start < n ; start += blockSize){
+			int count = std::min(blockSize, n-start);
+			const Vec3b* input = inputRow+start;
+			Vec3f* output = outputRow+start;
+
+			nsRGBtoXYZBlock(table, matrix, input, output, count);
+			XYZtoLuvBlock(fast, output, count);
+		}
+	}, type);
+}
+
+//Header of an nsRGB to Luv table file. It is followed by the fixed point Luv values of all 2^24
+//colors in CV_16SC3 layout, indexed by (R<<16)|(G<<8)|B. The header is 64 bytes so the
+//values stay aligned in the mapping
+struct LuvTableHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t byteOrder;
+	uint32_t entries;
+	float white[3];
+	int32_t scale;
+	char reserved[28];
+};
+
+static const char luvTableMagic[8]={'L','U','V','T','A','B','L','E'};
+static const int luvTableEntries=1<<24;
+
+//Table mapped by loadLuvTable, null when nsRGB to Luv is computed
+static const Vec3s* luvTable=0;
+static void* luvTableMapping=0;
+static size_t luvTableBytes=0;
+
+//Function returns the index of an 8 bit RGB color in the nsRGB to Luv table
+static inline int luvTableIndex(const Vec3b& nsRGBval){
+	return (nsRGBval[0]<<16)|(nsRGBval[1]<<8)|nsRGBval[2];
+}
+
+//Function returns a header for a table made with the white point of this build
+static LuvTableHeader luvTableHeader(){
+	LuvTableHeader header;
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, luvTableMagic, sizeof(header.magic));
+	header.version=1;
+	header.byteOrder=0x01020304;
+	header.entries=luvTableEntries;
+	header.white[0]=Xw;
+	header.white[1]=Yw;
+	header.white[2]=Zw;
+	header.scale=LuvFixedOne;
+	return header;
+}
+
+//Function computes Luv for every 24 bit nsRGB color with the float conversion, rounds it to fixed
+//point steps and writes the table to a file. Returns false when the file can't be written
+bool writeLuvTable(const string& path){
+	Mat colors(4096, 4096, CV_8UC3);
+	for(int i = 0 ; i < colors.rows ; i++){
+		Vec3b* row=colors.ptr<Vec3b>(i);
+		for(int j = 0 ; j < colors.cols ; j++){
+			int color=i*colors.cols+j;
+			row[j]=Vec3b(color>>16, (color>>8)&255, color&255);
+		}
+	}
+
+	//The table holds the exact float conversion whatever the current settings are, computed by the
+	//kernel directly so no setting changes under other threads and the conversion cache is left alone
+	Mat Luv, fixedLuv;
+	nsRGBtoLuvKernel(colors, Luv, false, CV_32FC3);
+	Luv.convertTo(fixedLuv, CV_16S, LuvFixedOne);
+
+	LuvTableHeader header=luvTableHeader();
+	ofstream file(path.c_str(), ios::binary);
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)fixedLuv.ptr<Vec3s>(0), (streamsize)luvTableEntries*sizeof(Vec3s));
+	file.close();
+	if(!file){
+		cout << "WARNING: Could not write Luv table " << path << "." << endl;
+		return false;
+	}
+	return true;
+}
+
+//Function unmaps the nsRGB to Luv table, nsRGB to Luv is computed again
+void unloadLuvTable(){
+#ifndef _WIN32
+	if(luvTableMapping) munmap(luvTableMapping, luvTableBytes);
+#endif
+	luvTable=0;
+	luvTableMapping=0;
+	luvTableBytes=0;
+}
+
+//Function maps an nsRGB to Luv table file read only and shared, so processes using the same
+//file share one copy in the page cache. Returns false, keeping no table, when the file can't
+//be mapped or was made for another white point or byte order
+bool loadLuvTable(const string& path){
+	unloadLuvTable();
+#ifdef _WIN32
+	cout << "WARNING: Luv tables are not supported on this platform." << endl;
+	return false;
+#else
+	size_t bytes=sizeof(LuvTableHeader)+(size_t)luvTableEntries*sizeof(Vec3s);
+	int fd=open(path.c_str(), O_RDONLY);
+	if(fd<0){
+		cout << "WARNING: Could not open Luv table " << path << "." << endl;
+		return false;
+	}
+
+	struct stat info;
+	void* mapping=MAP_FAILED;
+	if(fstat(fd, &info)==0 && (size_t)info.st_size==bytes){
+		mapping=mmap(0, bytes, PROT_READ, MAP_SHARED, fd, 0);
+	}
+	close(fd);
+	if(mapping==MAP_FAILED){
+		cout << "WARNING: Could not map Luv table " << path << "." << endl;
+		return false;
+	}
+
+	LuvTableHeader expected=luvTableHeader();
+	if(memcmp(mapping, &expected, sizeof(expected))!=0){
+		cout << "WARNING: Luv table " << path << " does not match this build." << endl;
+		munmap(mapping, bytes);
+		return false;
+	}
+
+	luvTableMapping=mapping;
+	luvTableBytes=bytes;
+	luvTable=(const Vec3s*)((const char*)mapping+sizeof(LuvTableHeader));
+	return true;
+#endif
+}
+
+//Header of a conversion cache file. It is followed by the planes of the converted image, each
+//rows x cols of the given type, stored row after row. Everything but the magic number is part of
+//the key, so a file is only reused for the same pixels converted with the same settings
+struct CacheHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t byteOrder;
+	uint64_t content[2];
+	int32_t rows;
+	int32_t cols;
+	int32_t type;
+	int32_t planes;
+	int32_t space;
+	int32_t fastMath;
+	int32_t table;
+	float white[3];
+	char reserved[60];
+};
+
+static const char cacheMagic[8]={'C','O','N','V','C','A','C','H'};
+
+//Directory of the conversion cache, empty while the cache is off, and the bound on its size
+static string cacheDirectory;
+static size_t cacheMaxBytes=0;
+
+//Function turns the conversion cache on in a directory, creating it when it is missing, or off for
+//an empty directory. Returns false, leaving the cache off, when the directory can't be used
+bool setConversionCache(const string& directory, size_t maxBytes){
+	cacheDirectory.clear();
+	cacheMaxBytes=0;
+	if(directory.empty()) return true;
+#ifdef _WIN32
+	cout << "WARNING: The conversion cache is not supported on this platform." << endl;
+	return false;
+#else
+	struct stat info;
+	mkdir(directory.c_str(), 0777);
+	if(stat(directory.c_str(), &info)!=0 || !S_ISDIR(info.st_mode) || access(directory.c_str(), W_OK)!=0){
+		cout << "WARNING: Could not use " << directory << " as the conversion cache." << endl;
+		return false;
+	}
+	cacheDirectory=directory;
+	cacheMaxBytes=maxBytes;
+	return true;
+#endif
+}
+
+//Function mixes a 64 bit word into a running hash
+static inline uint64_t mixHash(uint64_t hash, uint64_t word){
+	word*=0x87c37b91114253d5ULL;
+	word=(word<<31)|(word>>33);
+	hash^=word*0x4cf5ad432745937fULL;
+	hash=(hash<<27)|(hash>>37);
+	return hash*5+0x52dce729;
+}
+
+//Function computes two independent 64 bit hashes of the size, type and pixels of an image.
+//Chunks of 64 rows are hashed in parallel and combined in order, so the hashes don't depend on the thread count
+static void contentHash(const Mat& image, uint64_t hash[2]){
+	const int chunkRows=64;
+	int chunks=(image.rows+chunkRows-1)/chunkRows;
+	size_t rowBytes=image.cols*image.elemSize();
+	vector<uint64_t> chunkHash(2*chunks);
+
+	forEachStripe(chunks, std::min(stripeCount((double)image.total()), std::max(chunks, 1)), [&](int, int start, int end){
+		for(int c = start ; c < end ; c++){
+			uint64_t first=0x9e3779b97f4a7c15ULL;
+			uint64_t second=0xc2b2ae3d27d4eb4fULL;
+			for(int j = c*chunkRows ; j < std::min((c+1)*chunkRows, image.rows) ; j++){
+				const uchar* row=image.ptr<uchar>(j);
+				size_t i=0;
+				for( ; i+8 <= rowBytes ; i += 8){
+					uint64_t word;
+					memcpy(&word, row+i, 8);
+					first=mixHash(first, word);
+					second=mixHash(second, word^0xff51afd7ed558ccdULL);
+				}
+				uint64_t tail=0;
+				memcpy(&tail, row+i, rowBytes-i);
+				first=mixHash(first, tail);
+				second=mixHash(second, tail^0xff51afd7ed558ccdULL);
+			}
+			chunkHash[2*c]=first;
+			chunkHash[2*c+1]=second;
+		}
+	});
+
+	hash[0]=mixHash(mixHash(0, image.rows), ((uint64_t)image.cols<<32)|(uint32_t)image.type());
+	hash[1]=mixHash(hash[0], 0x2545f4914f6cdd1dULL);
+	for(int c = 0 ; c < chunks ; c++){
+		hash[0]=mixHash(hash[0], chunkHash[2*c]);
+		hash[1]=mixHash(hash[1], chunkHash[2*c+1]);
+	}
+return void();
+}
+
+//Function fills the cache header of an nsRGB image converted to a color space with the current
+//settings into planes planes, and returns the path of its cache file
+static string cacheEntry(const Mat& nsRGB, ColorSpace space, int planes, CacheHeader* header){
+	memset(header, 0, sizeof(*header));
+	memcpy(header->magic, cacheMagic, sizeof(header->magic));
+	header->version=1;
+	header->byteOrder=0x01020304;
+	contentHash(nsRGB, header->content);
+	header->rows=nsRGB.rows;
+	header->cols=nsRGB.cols;
+	header->type=CV_MAKETYPE(getIntermediateDepth(), planes==1 ? 3 : 1);
+	header->planes=planes;
+	header->space=space;
+	header->fastMath=useFastMath();
+	header->table=(space==SPACE_Luv && luvTable!=0);
+	header->white[0]=Xw;
+	header->white[1]=Yw;
+	header->white[2]=Zw;
+
+	//The file name is a hash of the whole header
+	uint64_t key=0;
+	uint64_t words[sizeof(CacheHeader)/8];
+	memcpy(words, header, sizeof(words));
+	for(size_t w = 0 ; w < sizeof(CacheHeader)/8 ; w++) key=mixHash(key, words[w]);
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.cache", (unsigned long long)key);
+	return cacheDirectory+"/"+name;
+}
+
+//Function returns the bytes of one plane of a cache file, planes hold 32 or 16 bit floats
+static size_t cachePlaneBytes(const CacheHeader& header){
+	size_t valueBytes=CV_MAT_DEPTH(header.type)==CV_16F ? 2 : 4;
+	return (size_t)header.rows*header.cols*CV_MAT_CN(header.type)*valueBytes;
+}
+
+//Function maps a cache file and copies its planes into the given Mats. Returns false when the cache is
+//off or holds no matching file. A file that is used is touched, so eviction drops the least recently used
+static bool loadCached(const Mat& nsRGB, ColorSpace space, Mat** planes, int count, CacheHeader* header, string* path){
+	if(cacheDirectory.empty()) return false;
+	*path=cacheEntry(nsRGB, space, count, header);
+#ifdef _WIN32
+	return false;
+#else
+	size_t bytes=sizeof(CacheHeader)+count*cachePlaneBytes(*header);
+	int fd=open(path->c_str(), O_RDONLY);
+	if(fd<0) return false;
+
+	struct stat info;
+	void* mapping=MAP_FAILED;
+	if(fstat(fd, &info)==0 && (size_t)info.st_size==bytes){
+		mapping=mmap(0, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+	}
+	close(fd);
+	if(mapping==MAP_FAILED) return false;
+	if(memcmp(mapping, header, sizeof(CacheHeader))!=0){
+		munmap(mapping, bytes);
+		return false;
+	}
+
+	const uchar* data=(const uchar*)mapping+sizeof(CacheHeader);
+	for(int p = 0 ; p < count ; p++){
+		planes[p]->create(header->rows, header->cols, header->type);
+		Mat stored(header->rows, header->cols, header->type, (void*)(data+p*cachePlaneBytes(*header)));
+		stored.copyTo(*planes[p]);
+	}
+	munmap(mapping, bytes);
+	utimes(path->c_str(), 0);
+	return true;
+#endif
+}
+
+//Function removes the least recently used cache files until the directory holds at most cacheMaxBytes
+static void evictCache(){
+#ifndef _WIN32
+	DIR* directory=opendir(cacheDirectory.c_str());
+	if(!directory) return void();
+
+	vector<pair<time_t,string> > files;
+	vector<size_t> sizes;
+	size_t total=0;
+	for(struct dirent* entry=readdir(directory) ; entry ; entry=readdir(directory)){
+		string name=entry->d_name;
+		struct stat info;
+		if(name.size()<6 || name.compare(name.size()-6, 6, ".cache")!=0) continue;
+		if(stat((cacheDirectory+"/"+name).c_str(), &info)!=0) continue;
+		files.push_back(make_pair(info.st_mtime, name));
+		total+=info.st_size;
+	}
+	closedir(directory);
+
+	sort(files.begin(), files.end());
+	for(size_t f = 0 ; f < files.size() && total>cacheMaxBytes ; f++){
+		struct stat info;
+		string path=cacheDirectory+"/"+files[f].second;
+		if(stat(path.c_str(), &info)==0 && unlink(path.c_str())==0) total-=std::min(total, (size_t)info.st_size);
+	}
+#endif
+return void();
+}
+
+//Number of cache files written by this process, which makes every temporary name unique
+static atomic<unsigned> cacheWrites(0);
+
+//Function writes the planes of a converted image to its cache file and evicts old files. The file is
+//written under a temporary name of its own, from the process id and a count of the writes, and
+//renamed, so neither other processes nor other threads ever map or write over a partly written file.
+//Images larger than the whole cache are not stored
+static void storeCached(const Mat* planes, int count, const CacheHeader& header, const string& path){
+	if(cacheDirectory.empty()) return void();
+	size_t bytes=sizeof(CacheHeader)+count*cachePlaneBytes(header);
+	if(bytes>cacheMaxBytes) return void();
+#ifndef _WIN32
+	string temporary=path+"."+to_string((long long)getpid())+"."+to_string((unsigned long long)cacheWrites++);
+	ofstream file(temporary.c_str(), ios::binary);
+	file.write((const char*)&header, sizeof(header));
+	for(int p = 0 ; p < count ; p++){
+		for(int j = 0 ; j < planes[p].rows ; j++){
+			file.write((const char*)planes[p].ptr(j), (streamsize)(planes[p].cols*planes[p].elemSize()));
+		}
+	}
+	file.close();
+	if(!file || rename(temporary.c_str(), path.c_str())!=0){
+		cout << "WARNING: Could not write conversion cache file " << path << "." << endl;
+		unlink(temporary.c_str());
+		return void();
+	}
+	evictCache();
+#endif
+return void();
+}
+
+//Function takes non-linear scaled [0-255] byte (uint) RGB Mat object reference
+//and updates Luv Mat object reference in a single pass.
+//Equivalent to nsRGBtonRGB, nRGBtolRGB, lRGBtoXYZ and XYZtoLuv run back to back,
+//but each pixel is read and written once and no intermediate images are allocated.
+//While a table is loaded each pixel is looked up instead, with Luv in fixed point steps
+static void computensRGBtoLuv(const Mat& nsRGB, Mat& Luv){
+	if(nsRGB.type()!=CV_8UC3){
+		cout << "WARNING: Input nsRGB image type is not CV_8UC3." << endl;
+		return void();
+	}
+	if(luvTable){
+		const Vec3s* lookup=luvTable;
+		convertPixels<Vec3b,Vec3f>(nsRGB, Luv, [lookup](const Vec3b& pixel){
+			const Vec3s& entry=lookup[luvTableIndex(pixel)];
+			return Vec3f(entry[0]*(1.0f/LuvFixedOne), entry[1]*(1.0f/LuvFixedOne), entry[2]*(1.0f/LuvFixedOne));
+		});
+		return void();
+	}
+	nsRGBtoLuvKernel(nsRGB, Luv, useFastMath(), storageType<Vec3f>());
+return void();
+}
+
+//Function takes non-linear scaled [0-255] byte (uint) RGB Mat object reference
+//and updates planar Luv image reference in a single pass, or by lookup while a table is loaded
+static void computensRGBtoLuv(const Mat& nsRGB, PlanarImage& Luv){
+	if(nsRGB.type()!=CV_8UC3){
+		cout << "WARNING: Input nsRGB image type is not CV_8UC3." << endl;
+		return void();
+	}
+	if(luvTable){
+		const Vec3s* lookup=luvTable;
+		convertRowsToPlanar<Vec3b>(nsRGB, Luv, [lookup](const Vec3b* inputRow, float* L, float* u, float* v, int n){
+			for(int i = 0 ; i < n ; i++){
+				const Vec3s& entry=lookup[luvTableIndex(inputRow[i])];
+				L[i]=entry[0]*(1.0f/LuvFixedOne);
+				u[i]=entry[1]*(1.0f/LuvFixedOne);
+				v[i]=entry[2]*(1.0f/LuvFixedOne);
+			}
+		});
+		return void();
+	}
+	const float* table=invgammaTable();
+	MatrixRowFunc matrix=matrixRow();
+	bool fast=useFastMath();
+
+	//Each block goes through XYZ and Luv in a small buffer before it is copied to the planes
+	convertRowsToPlanar<Vec3b>(nsRGB, Luv, [table,matrix,fast](const Vec3b* inputRow, float* L, float* u, float* v, int n){
+		Vec3f buffer[blockSize];
+
+		for(int start = 0 ; start < n ; start += blockSize){
+			int count = std::min(blockSize, n-start);
+
+			nsRGBtoXYZBlock(table, matrix, inputRow+start, buffer, count);
+			XYZtoLuvBlock(fast, buffer, count);
+			scatterBlock(buffer, L+start, u+start, v+start, count);
+		}
+	});
+return void();
+}
+
+//Function takes non-linear scaled [0-255] byte (uint) RGB Mat object reference
+//and updates xyY Mat object reference in a single pass.
+//Equivalent to nsRGBtonRGB, nRGBtolRGB, lRGBtoXYZ and XYZtoxyY run back to back
+static void computensRGBtoxyY(const Mat& nsRGB, Mat& xyY){
+	if(nsRGB.type()!=CV_8UC3){
+		cout << "WARNING: Input nsRGB image type is not CV_8UC3." << endl;
+		return void();
+	}
+	const float* table=invgammaTable();
+	MatrixRowFunc matrix=matrixRow();
+
+	//Each block of the output row holds lRGB, then XYZ, then the final xyY values
+	convertRows<Vec3b,Vec3f>(nsRGB, xyY, [table,matrix](const Vec3b* inputRow, Vec3f* outputRow, int n){
+		for(int start = 0 ; start < n ; start += blockSize){
+			int count = std::min(blockSize, n-start);
+			const Vec3b* input = inputRow+start;
+			Vec3f* output = outputRow+start;
+
+			nsRGBtoXYZBlock(table, matrix, input, output, count);
+			XYZtoxyYBlock(output, count);
+		}
+	});
+return void();
+}
+
+//Function takes non-linear scaled [0-255] byte (uint) RGB Mat object reference
+//and updates planar xyY image reference in a single pass
+static void computensRGBtoxyY(const Mat& nsRGB, PlanarImage& xyY){
+	if(nsRGB.type()!=CV_8UC3){
+		cout << "WARNING: Input nsRGB image type is not CV_8UC3." << endl;
+		return void();
+	}
+	const float* table=invgammaTable();
+	MatrixRowFunc matrix=matrixRow();
+
+	//Each block goes through XYZ and xyY in a small buffer before it is copied to the planes
+	convertRowsToPlanar<Vec3b>(nsRGB, xyY, [table,matrix](const Vec3b* inputRow, float* x, float* y, float* Y, int n){
+		Vec3f buffer[blockSize];
+
+		for(int start = 0 ; start < n ; start += blockSize){
+			int count = std::min(blockSize, n-start);
+
+			nsRGBtoXYZBlock(table, matrix, inputRow+start, buffer, count);
+			XYZtoxyYBlock(buffer, count);
+			scatterBlock(buffer, x+start, y+start, Y+start, count);
+		}
+	});
+return void();
+}
+
+//Function takes non-linear scaled [0-255] byte (uint) RGB Mat object reference and updates Luv
+//Mat object reference, from the conversion cache when it holds this image
+void nsRGBtoLuv(const Mat& nsRGB, Mat& Luv){
+	CacheHeader header;
+	string path;
+	Mat* planes[1]={&Luv};
+
+	if(nsRGB.type()==CV_8UC3 && loadCached(nsRGB, SPACE_Luv, planes, 1, &header, &path)) return void();
+	computensRGBtoLuv(nsRGB, Luv);
+	if(!path.empty()) storeCached(&Luv, 1, header, path);
+return void();
+}
+
+//Function takes non-linear scaled [0-255] byte (uint) RGB Mat object reference and updates planar
+//Luv image reference, from the conversion cache when it holds this image
+void nsRGBtoLuv(const Mat& nsRGB, PlanarImage& Luv){
+	CacheHeader header;
+	string path;
+	Mat* planes[3]={&Luv.planes[0], &Luv.planes[1], &Luv.planes[2]};
+
+	if(nsRGB.type()==CV_8UC3 && loadCached(nsRGB, SPACE_Luv, planes, 3, &header, &path)) return void();
+	computensRGBtoLuv(nsRGB, Luv);
+	if(!path.empty()) storeCached(Luv.planes, 3, header, path);
+return void();
+}
+
+//Function takes non-linear scaled [0-255] byte (uint) RGB Mat object reference and updates xyY
+//Mat object reference, from the conversion cache when it holds this image
+void nsRGBtoxyY(const Mat& nsRGB, Mat& xyY){
+	CacheHeader header;
+	string path;
+	Mat* planes[1]={&xyY};
+
+	if(nsRGB.type()==CV_8UC3 && loadCached(nsRGB, SPACE_xyY, planes, 1, &header, &path)) return void();
+	computensRGBtoxyY(nsRGB, xyY);
+	if(!path.empty()) storeCached(&xyY, 1, header, path);
+return void();
+}
+
+//Function takes non-linear scaled [0-255] byte (uint) RGB Mat object reference and updates planar
+//xyY image reference, from the conversion cache when it holds this image
+void nsRGBtoxyY(const Mat& nsRGB, PlanarImage& xyY){
+	CacheHeader header;
+	string path;
+	Mat* planes[3]={&xyY.planes[0], &xyY.planes[1], &xyY.planes[2]};
+
+	if(nsRGB.type()==CV_8UC3 && loadCached(nsRGB, SPACE_xyY, planes, 3, &header, &path)) return void();
+	computensRGBtoxyY(nsRGB, xyY);
+	if(!path.empty()) storeCached(xyY.planes, 3, header, path);
+return void();
+}
+
+//Function takes Luv Mat object reference and updates stretchLuv Mat object reference
+//with linearly stretched [0-100] L values
+void stretchLuv(const Mat& Luv, Mat& stretchLuv){
+	Point min_loc, max_loc;
+	double min,max;
+
+	//Only L is taken out of the image and put back, u and v are copied once with the image.
+	//Half float L is widened to 32 bit float for minMaxLoc and narrowed again afterwards
+	Mat L;
+	extractChannel(Luv, L, 0);
+	if(L.depth()!=CV_32F) L.convertTo(L, CV_32F);
+
+	minMaxLoc(L, &min, &max, &min_loc, &max_loc);
+
+	Mat Lstretch=(L-min)*100/max;
+	if(Luv.depth()!=CV_32F) Lstretch.convertTo(Lstretch, Luv.depth());
+
+	Luv.copyTo(stretchLuv);
+	insertChannel(Lstretch, stretchLuv, 0);
+
+	return void();
+}
+
+//Function takes planar Luv image reference and updates planar stretchLuv image reference
+//with linearly stretched [0-100] L values. The u and v planes are shared with the input
+void stretchLuv(const PlanarImage& Luv, PlanarImage& stretchLuv){
+	Point min_loc, max_loc;
+	double min,max;
+
+	if(!checkPlanar(Luv, "Luv")) return void();
+
+	Mat L=outputPlane(Luv, stretchLuv, 0);
+	if(Luv.planes[0].depth()==CV_32F){
+		minMaxLoc(Luv.planes[0], &min, &max, &min_loc, &max_loc);
+		L=(Luv.planes[0]-min)*100/max;
+	}else{
+		//Half float L is widened to 32 bit float for minMaxLoc and narrowed again afterwards
+		Mat Lfloat;
+		Luv.planes[0].convertTo(Lfloat, CV_32F);
+		minMaxLoc(Lfloat, &min, &max, &min_loc, &max_loc);
+		Mat Lstretch=(Lfloat-min)*100/max;
+		Lstretch.convertTo(L, Luv.planes[0].depth());
+	}
+	stretchLuv.planes[0]=L;
+	stretchLuv.planes[1]=Luv.planes[1];
+	stretchLuv.planes[2]=Luv.planes[2];
+
+	return void();
+}
+
+//Function converts a single xyY pixel to an XYZ pixel
+static inline Vec3f xyYtoXYZPixel(const Vec3f& xyYval){
+	Vec3f color;
+
+	float x = xyYval[0];
+	float y = xyYval[1];
+	float Y = xyYval[2];
+	float X,Z;
+
+	if(y>0.000001){
+		X=x*Y/y;
+		Z=(1.0-x-y)*Y/y;
+		if(X<0.0) X=0.0;
+		if(Y<0.0) Y=0.0;
+		if(Z<0.0) Z=0.0;
+		color[0]=X;
+		color[1]=Y;
+		color[2]=Z;
+	}else{
+		color[0]=0.0;
+		color[1]=0.0;
+		color[2]=0.0;
+	}
+	return color;
+}
+
+//Function takes an xyY Mat object reference
+//and updates XYZ Mat object reference
+void xyYtoXYZ(const Mat& xyY, Mat& XYZ){
+	convertPixels<Vec3f,Vec3f>(xyY, XYZ, [](const Vec3f& pixel){ return xyYtoXYZPixel(pixel); });
+return void();
+}
+
+//Function converts a single Luv pixel to an XYZ pixel
+static inline Vec3f LuvtoXYZPixel(const Vec3f& Luvval){
+	Vec3f color;
+
+	float L = Luvval[0];
+	float u = Luvval[1];
+	float v = Luvval[2];
+	float X,Y,Z;
+	float uprime, vprime;
+
+	//Compute uprime and vprime
+	if(L>0.000001){
+		uprime=(u+13.0*uw*L)/(13.0*L);
+		vprime=(v+13.0*vw*L)/(13.0*L);
+
+		//Compute Y
+		if(L>7.9996){
+			Y=pow((L+16.0)/116.0,3.0)*Yw;
+		}else{
+			Y=L*Yw/903.3;
+		}
+
+		//Compute X and Z
+		if(vprime<0.001){
+			X=0.0;
+			Z=0.0;
+		}else{
+			X=Y*2.25*uprime/vprime;
+			Z=Y*(3.0-0.75*uprime-5.0*vprime)/vprime;
+		}
+	}else{
+		X=0.0;
+		Y=0.0;
+		Z=0.0;
+	}
+
+	if(X<0.0) X=0.0;
+	if(Y<0.0) Y=0.0;
+	if(Z<0.0) Z=0.0;
+	color[0]=X;
+	color[1]=Y;
+	color[2]=Z;
+	return color;
+}
+
+//Function takes an Luv RGB Mat object reference
+//and updates XYZ Mat object reference
+void LuvtoXYZ(const Mat& Luv, Mat& XYZ){
+	convertPixels<Vec3f,Vec3f>(Luv, XYZ, [](const Vec3f& pixel){ return LuvtoXYZPixel(pixel); });
+	return void();
+}
+
+//Function converts a single XYZ pixel to a linear [0-1] RGB pixel
+static inline Vec3f XYZtolRGBPixel(const Vec3f& XYZval){
+	Vec3f color;
+
+	float X = XYZval[0];
+	float Y = XYZval[1];
+	float Z = XYZval[2];
+	float R,G,B;
+
+	R=(3.240479*X-1.53715*Y-0.498535*Z);
+	G=(-0.969256*X+1.875991*Y+0.041556*Z);
+	B=(0.055648*X-0.204043*Y+1.057311*Z);
+
+	if(R<0.0) R=0.0;
+	if(G<0.0) G=0.0;
+	if(B<0.0) B=0.0;
+	if(R>1.0) R=1.0;
+	if(G>1.0) G=1.0;
+	if(B>1.0) B=1.0;
+	color[0]=R;
+	color[1]=G;
+	color[2]=B;
+	return color;
+}
+
+//Function takes an XYZ Mat object reference
+//and updates a linear RGB Mat object reference
+void XYZtolRGB(const Mat& XYZ, Mat& lRGB){
+	MatrixRowFunc matrix=matrixRow();
+
+	convertRows<Vec3f,Vec3f>(XYZ, lRGB, [matrix](const Vec3f* inputRow, Vec3f* outputRow, int n){
+		matrix(XYZtolRGBMatrix, true, inputRow, outputRow, n);
+	});
+	return void();
+}
+
+//Function computes gamma correction of a single plane Mat object
+float gamma(float v){
+	float answer;
+
+	if(v<0.00304){
+		answer = v*12.92;
+	}else{
+		answer = 1.055*pow(v,1.0/2.4)-0.055;
+	}
+
+	return answer;
+}
+
+//Function computes gamma correction of a float using fastPow1_2_4.
+//Both segments are evaluated and one is selected so loops over pixels can be vectorized
+static inline float fastGamma(float v){
+	float linear=v*12.92f;
+	float power=1.055f*fastPow1_2_4(v)-0.055f;
+
+	return fastSelect(v<0.00304f, linear, power);
+}
+
+//Function converts a single linear [0-1] RGB pixel to a non-linear [0-1] RGB pixel
+static inline Vec3f lRGBtonRGBPixel(const Vec3f& lRGBval){
+	Vec3f color;
+
+	float lR = lRGBval[0];
+	float lG = lRGBval[1];
+	float lB = lRGBval[2];
+	float nR,nG,nB;
+
+	nR=gamma(lR);
+	nG=gamma(lG);
+	nB=gamma(lB);
+
+	if(nR<0.0) nR=0.0;
+	if(nG<0.0) nG=0.0;
+	if(nB<0.0) nB=0.0;
+	if(nR>1.0) nR=1.0;
+	if(nG>1.0) nG=1.0;
+	if(nB>1.0) nB=1.0;
+
+	color[0]=nR;
+	color[1]=nG;
+	color[2]=nB;
+	return color;
+}
+
+//Function takes linear [0-1] RGB Mat object reference
+//and updates XYZ Mat object reference
+void lRGBtonRGB(const Mat& lRGB, Mat& nRGB){
+	if(useFastMath()){
+		convertRows<Vec3f,Vec3f>(lRGB, nRGB, curveRow<fastGamma>);
+	}else{
+		convertRows<Vec3f,Vec3f>(lRGB, nRGB, curveRow<gamma>);
+	}
+return void();
+}
+
+//Function converts a single non-linear [0-1] RGB pixel
+//to a non-linear scaled [0-255] byte RGB pixel
+static inline Vec3b nRGBtonsRGBPixel(const Vec3f& nRGBval){
+	Vec3b color;
+
+	float nR = nRGBval[0];
+	float nG = nRGBval[1];
+	float nB = nRGBval[2];
+	uint nsR,nsG,nsB;
+
+	nsR=255*nR;
+	nsG=255*nG;
+	nsB=255*nB;
+
+	if(nsR<0) nsR=0;
+	if(nsG<0) nsG=0;
+	if(nsB<0) nsB=0;
+	if(nsR>255) nsR=255;
+	if(nsG>255) nsG=255;
+	if(nsB>255) nsB=255;
+
+	color[0]=nsR;
+	color[1]=nsG;
+	color[2]=nsB;
+	return color;
+}
+
+//Function takes non-linear [0-1] RGB Mat object reference
+//and updates nonlinear scaled [0-255] RGB Mat object reference
+void nRGBtonsRGB(const Mat& nRGB, Mat& nsRGB){
+	convertPixels<Vec3f,Vec3b>(nRGB, nsRGB, [](const Vec3f& pixel){ return nRGBtonsRGBPixel(pixel); });
+return void();
+}
+
+//Table of the smallest linear [0-1] value that quantizes to each byte value 1-255.
+//lRGBtonRGBPixel followed by nRGBtonsRGBPixel is non-decreasing in its input,
+//so the byte value of a linear value is the number of thresholds it reaches.
+//Thresholds are found by bisection over the float bit patterns in [0,1],
+//so the result matches the pow() path bit for bit
+struct GammaThresholds {
+	float value[256];
+
+	GammaThresholds(){
+		float one=1.0;
+		uint32_t top;
+		memcpy(&top, &one, sizeof(top));
+
+		value[0]=0.0;
+		for(int k = 1 ; k < 256 ; k++){
+			uint32_t low=0;
+			uint32_t high=top;
+			while(low<high){
+				uint32_t middle=low+(high-low)/2;
+				if(quantize(middle)>=k) high=middle;
+				else low=middle+1;
+			}
+			memcpy(&value[k], &low, sizeof(float));
+		}
+	}
+
+	static int quantize(uint32_t bits){
+		float lvalue;
+		memcpy(&lvalue, &bits, sizeof(lvalue));
+		Vec3f lRGBval(lvalue,lvalue,lvalue);
+		return nRGBtonsRGBPixel(lRGBtonRGBPixel(lRGBval))[0];
+	}
+};
+
+//Function returns the gamma threshold table, built on first use
+static const float* gammaThresholds(){
+	static const GammaThresholds table;
+	return table.value;
+}
+
+//Function quantizes a single linear [0-1] value to a non-linear scaled [0-255] byte value
+//with a branch-free binary search of the gamma threshold table
+static inline uchar lRGBtonsRGBValue(const float* thresholds, float lvalue){
+	int k=0;
+
+	for(int step = 128 ; step > 0 ; step >>= 1){
+		if(thresholds[k+step]<=lvalue) k+=step;
+	}
+	return (uchar)k;
+}
+
+//Function converts a single linear [0-1] RGB pixel
+//to a non-linear scaled [0-255] byte RGB pixel using the gamma threshold table
+static inline Vec3b lRGBtonsRGBPixel(const float* thresholds, const Vec3f& lRGBval){
+	Vec3b color;
+
+	color[0]=lRGBtonsRGBValue(thresholds, lRGBval[0]);
+	color[1]=lRGBtonsRGBValue(thresholds, lRGBval[1]);
+	color[2]=lRGBtonsRGBValue(thresholds, lRGBval[2]);
+	return color;
+}
+
+//Function takes linear [0-1] RGB Mat object reference
+//and updates nonlinear scaled [0-255] RGB Mat object reference.
+//Equivalent to lRGBtonRGB followed by nRGBtonsRGB, using a 255 entry threshold table
+void lRGBtonsRGB(const Mat& lRGB, Mat& nsRGB){
+	const float* thresholds=gammaThresholds();
+
+	convertPixels<Vec3f,Vec3b>(lRGB, nsRGB, [thresholds](const Vec3f& pixel){ return lRGBtonsRGBPixel(thresholds, pixel); });
+return void();
+}
+
+//Function converts a block of XYZ pixels to non-linear scaled [0-255] byte RGB pixels
+//with the matrix kernel and the gamma thresholds, the XYZ block is overwritten with lRGB
+static inline void XYZtonsRGBBlock(const float* thresholds, MatrixRowFunc matrix, Vec3f* XYZ, Vec3b* output, int count){
+	matrix(XYZtolRGBMatrix, true, XYZ, XYZ, count);
+	for(int i = 0 ; i < count ; i++) output[i]=lRGBtonsRGBPixel(thresholds, XYZ[i]);
+}
+
+//Function takes Luv Mat object reference and updates non-linear scaled [0-255]
+//byte RGB Mat object reference in a single pass.
+//Equivalent to LuvtoXYZ, XYZtolRGB, lRGBtonRGB and nRGBtonsRGB run back to back,
+//but clamping and quantization happen per pixel and no intermediate images are allocated
+void LuvtonsRGB(const Mat& Luv, Mat& nsRGB){
+	if(!isFloatImage(Luv)){
+		cout << "WARNING: Input Luv image type is not CV_32FC3 or CV_16FC3." << endl;
+		return void();
+	}
+	const float* thresholds=gammaThresholds();
+	MatrixRowFunc matrix=matrixRow();
+
+	//Each block goes through XYZ and lRGB in a small buffer before quantization
+	convertRows<Vec3f,Vec3b>(Luv, nsRGB, [thresholds,matrix](const Vec3f* inputRow, Vec3b* outputRow, int n){
+		Vec3f buffer[blockSize];
+
+		for(int start = 0 ; start < n ; start += blockSize){
+			int count = std::min(blockSize, n-start);
+			const Vec3f* input = inputRow+start;
+			Vec3b* output = outputRow+start;
+
+			for(int i = 0 ; i < count ; i++) buffer[i]=LuvtoXYZPixel(input[i]);
+			XYZtonsRGBBlock(thresholds, matrix, buffer, output, count);
+		}
+	});
+return void();
+}
+
+//Function takes planar Luv image reference and updates non-linear scaled [0-255]
+//byte RGB Mat object reference in a single pass
+void LuvtonsRGB(const PlanarImage& Luv, Mat& nsRGB){
+	if(!checkPlanar(Luv, "Luv")) return void();
+	const float* thresholds=gammaThresholds();
+	MatrixRowFunc matrix=matrixRow();
+
+	//Each block is gathered from the planes and goes through XYZ and lRGB in a small buffer
+	convertRowsFromPlanar<Vec3b>(Luv, nsRGB, [thresholds,matrix](const float* L, const float* u, const float* v, Vec3b* outputRow, int n){
+		Vec3f buffer[blockSize];
+
+		for(int start = 0 ; start < n ; start += blockSize){
+			int count = std::min(blockSize, n-start);
+
+			gatherBlock(L+start, u+start, v+start, buffer, count);
+			for(int i = 0 ; i < count ; i++) buffer[i]=LuvtoXYZPixel(buffer[i]);
+			XYZtonsRGBBlock(thresholds, matrix, buffer, outputRow+start, count);
+		}
+	});
+return void();
+}
+
+//Function takes xyY Mat object reference and updates non-linear scaled [0-255]
+//byte RGB Mat object reference in a single pass.
+//Equivalent to xyYtoXYZ, XYZtolRGB, lRGBtonRGB and nRGBtonsRGB run back to back
+void xyYtonsRGB(const Mat& xyY, Mat& nsRGB){
+	if(!isFloatImage(xyY)){
+		cout << "WARNING: Input xyY image type is not CV_32FC3 or CV_16FC3." << endl;
+		return void();
+	}
+	const float* thresholds=gammaThresholds();
+	MatrixRowFunc matrix=matrixRow();
+
+	//Each block goes through XYZ and lRGB in a small buffer before quantization
+	convertRows<Vec3f,Vec3b>(xyY, nsRGB, [thresholds,matrix](const Vec3f* inputRow, Vec3b* outputRow, int n){
+		Vec3f buffer[blockSize];
+
+		for(int start = 0 ; start < n ; start += blockSize){
+			int count = std::min(blockSize, n-start);
+			const Vec3f* input = inputRow+start;
+			Vec3b* output = outputRow+start;
+
+			for(int i = 0 ; i < count ; i++) buffer[i]=xyYtoXYZPixel(input[i]);
+			XYZtonsRGBBlock(thresholds, matrix, buffer, output, count);
+		}
+	});
+return void();
+}
+
+//Function takes planar xyY image reference and updates non-linear scaled [0-255]
+//byte RGB Mat object reference in a single pass
+void xyYtonsRGB(const PlanarImage& xyY, Mat& nsRGB){
+	if(!checkPlanar(xyY, "xyY")) return void();
+	const float* thresholds=gammaThresholds();
+	MatrixRowFunc matrix=matrixRow();
+
+	//Each block is gathered from the planes and goes through XYZ and lRGB in a small buffer
+	convertRowsFromPlanar<Vec3b>(xyY, nsRGB, [thresholds,matrix](const float* x, const float* y, const float* Y, Vec3b* outputRow, int n){
+		Vec3f buffer[blockSize];
+
+		for(int start = 0 ; start < n ; start += blockSize){
+			int count = std::min(blockSize, n-start);
+
+			gatherBlock(x+start, y+start, Y+start, buffer, count);
+			for(int i = 0 ; i < count ; i++) buffer[i]=xyYtoXYZPixel(buffer[i]);
+			XYZtonsRGBBlock(thresholds, matrix, buffer, outputRow+start, count);
+		}
+	});
+return void();
+}
+
+//Side of the square blocks a MinMaxTable keeps the minimum and maximum of
+static const int minMaxBlock=32;
+
+//Function returns the largest k with 2^k <= n, for n >= 1
+static inline int floorLog2(int n){
+	int k=0;
+	while((2<<k) <= n) k++;
+	return k;
+}
+
+MinMaxTable::MinMaxTable(){
+	channel=0;
+	blocksX=0;
+	blocksY=0;
+	levelsX=0;
+	levelsY=0;
+}
+
+//Function builds the table over one channel of a float or fixed point image. Level (lx,ly) of the
+//sparse table holds, for every block, the minimum and maximum of the 2^lx x 2^ly blocks starting there
+bool MinMaxTable::build(const Mat& image, int channel){
+	if(image.depth()!=CV_32F && image.depth()!=CV_16F && image.depth()!=CV_16S && image.depth()!=CV_16U){
+		cout << "WARNING: Window statistics need a float or fixed point image." << endl;
+		return false;
+	}
+	if(image.channels()>3){
+		cout << "WARNING: Window statistics need an image of one to three channels." << endl;
+		return false;
+	}
+	if(channel<0 || channel>=image.channels()){
+		cout << "WARNING: Image has no channel " << channel << "." << endl;
+		return false;
+	}
+
+	this->image=image;
+	this->channel=channel;
+	blocksX=image.cols/minMaxBlock;
+	blocksY=image.rows/minMaxBlock;
+	levelsX=blocksX>0 ? floorLog2(blocksX)+1 : 0;
+	levelsY=blocksY>0 ? floorLog2(blocksY)+1 : 0;
+	size_t cells=(size_t)blocksX*blocksY;
+	minimum.assign(cells*levelsX*levelsY, 0.0f);
+	maximum.assign(cells*levelsX*levelsY, 0.0f);
+	if(cells==0) return true;
+
+	//Level (0,0) is read from the image, one stripe of block rows per thread
+	forEachStripe(blocksY, std::min(stripeCount((double)image.total()), blocksY), [&](int, int start, int end){
+		for(int by = start ; by < end ; by++){
+			for(int bx = 0 ; bx < blocksX ; bx++){
+				double low,high;
+				Rect block(bx*minMaxBlock, by*minMaxBlock, minMaxBlock, minMaxBlock);
+				windowMinMax(image, channel, block, &low, &high);
+				minimum[by*blocksX+bx]=(float)low;
+				maximum[by*blocksX+bx]=(float)high;
+			}
+		}
+	});
+
+	//Every other level combines two halves of the level below it in x, or in y on the first column of levels
+	for(int ly = 0 ; ly < levelsY ; ly++){
+		for(int lx = (ly==0 ? 1 : 0) ; lx < levelsX ; lx++){
+			bool alongX=(ly==0);
+			size_t from=((size_t)(alongX ? ly*levelsX+lx-1 : (ly-1)*levelsX+lx))*cells;
+			size_t to=((size_t)ly*levelsX+lx)*cells;
+			int stepX=alongX ? 1<<(lx-1) : 0;
+			int stepY=alongX ? 0 : 1<<(ly-1);
+
+			for(int by = 0 ; by+(1<<ly) <= blocksY ; by++){
+				for(int bx = 0 ; bx+(1<<lx) <= blocksX ; bx++){
+					size_t first=from+by*blocksX+bx;
+					size_t second=from+(by+stepY)*blocksX+bx+stepX;
+					minimum[to+by*blocksX+bx]=std::min(minimum[first], minimum[second]);
+					maximum[to+by*blocksX+bx]=std::max(maximum[first], maximum[second]);
+				}
+			}
+		}
+	}
+	return true;
+}
+
+//Function widens [low,high] to the minimum and maximum of the channel inside a rectangle of the image
+static void includeWindow(const Mat& image, int channel, int x, int y, int width, int height, float* low, float* high){
+	double min,max;
+
+	if(width<=0 || height<=0) return void();
+	windowMinMax(image, channel, Rect(x, y, width, height), &min, &max);
+	*low=std::min(*low, (float)min);
+	*high=std::max(*high, (float)max);
+return void();
+}
+
+//Function returns the minimum and maximum of the channel inside a window, clipped to the image.
+//The whole blocks inside the window come from four overlapping sparse table entries and the
+//partial blocks along its four sides are read from the image
+void MinMaxTable::minMax(const Rect& window, double* min, double* max) const{
+	const float infinity=numeric_limits<float>::infinity();
+	float low=infinity;
+	float high=-infinity;
+
+	int x0=std::max(window.x, 0);
+	int y0=std::max(window.y, 0);
+	int x1=std::min(window.x+window.width, image.cols);
+	int y1=std::min(window.y+window.height, image.rows);
+
+	int bx0=(x0+minMaxBlock-1)/minMaxBlock;
+	int by0=(y0+minMaxBlock-1)/minMaxBlock;
+	int bx1=std::min(x1/minMaxBlock, blocksX);
+	int by1=std::min(y1/minMaxBlock, blocksY);
+
+	if(x0<x1 && y0<y1 && bx0<bx1 && by0<by1){
+		int lx=floorLog2(bx1-bx0);
+		int ly=floorLog2(by1-by0);
+		size_t level=((size_t)ly*levelsX+lx)*blocksX*blocksY;
+		int corners[4][2]={{bx0, by0}, {bx1-(1<<lx), by0}, {bx0, by1-(1<<ly)}, {bx1-(1<<lx), by1-(1<<ly)}};
+		for(int c = 0 ; c < 4 ; c++){
+			size_t cell=level+(size_t)corners[c][1]*blocksX+corners[c][0];
+			low=std::min(low, minimum[cell]);
+			high=std::max(high, maximum[cell]);
+		}
+
+		//Rows above and below the whole blocks, then the columns beside them
+		int top=by0*minMaxBlock;
+		int bottom=by1*minMaxBlock;
+		includeWindow(image, channel, x0, y0, x1-x0, top-y0, &low, &high);
+		includeWindow(image, channel, x0, bottom, x1-x0, y1-bottom, &low, &high);
+		includeWindow(image, channel, x0, top, bx0*minMaxBlock-x0, bottom-top, &low, &high);
+		includeWindow(image, channel, bx1*minMaxBlock, top, x1-bx1*minMaxBlock, bottom-top, &low, &high);
+	}else{
+		includeWindow(image, channel, x0, y0, x1-x0, y1-y0, &low, &high);
+	}
+
+	//An empty window gives 0 for both, as windowMinMax does
+	if(low>high){
+		low=0.0f;
+		high=0.0f;
+	}
+	*min=low;
+	*max=high;
+return void();
+}
+
+//Function checks that a MinMaxTable was built over the given channel of an image of this size
+static bool checkMinMaxTable(const MinMaxTable& table, const Mat& image, int channel){
+	if(table.image.rows!=image.rows || table.image.cols!=image.cols || table.channel!=channel){
+		cout << "WARNING: Window statistics were built for another image or channel." << endl;
+		return false;
+	}
+	return true;
+}
+
+//Function stretches L of a float Luv image from [min,max] to [0,100] and copies u and v in a single pass
+static void stretchLuvRange(const Mat& Luv, Mat& stretchLuv, double min, double max){
+	convertPixels<Vec3f,Vec3f>(Luv, stretchLuv, [min,max](const Vec3f& pixel){
+		return Vec3f(stretchValue(pixel[0], min, max, 100.0), pixel[1], pixel[2]);
+	}, Luv.type());
+return void();
+}
+
+//Function copies x and y of a float xyY image and stretches Y from [min,max] to [0,1] in a single pass
+static void stretchxyYRange(const Mat& xyY, Mat& stretchxyY, double min, double max){
+	convertPixels<Vec3f,Vec3f>(xyY, stretchxyY, [min,max](const Vec3f& pixel){
+		return Vec3f(pixel[0], pixel[1], stretchValue(pixel[2], min, max, 1.0));
+	}, xyY.type());
+return void();
+}
+
+//Function takes Luv Mat object reference and window coordinates (w1,w2,h1,h2)
+//and updates stretchLuv Mat object reference with linearly stretched [0-100] L values
+//using stretch values from window coordinates
+void WindowStretchLuv(const Mat& Luv, Mat& stretchLuv, double w1, double w2, double h1, double h2){
+	double min,max;
+
+	if(!isFloatImage(Luv)){
+		cout << "WARNING: Input Luv image type is not CV_32FC3 or CV_16FC3." << endl;
+		return void();
+	}
+
+	windowMinMax(Luv, 0, windowRect(Luv.size(), w1, w2, h1, h2, 0), &min, &max);
+
+	//Stretch L and copy u and v in a single pass
+	stretchLuvRange(Luv, stretchLuv, min, max);
+
+return void();
+}
+
+//Function takes Luv Mat object reference, a MinMaxTable built over its L channel and window coordinates
+//(w1,w2,h1,h2) and updates stretchLuv Mat object reference with linearly stretched [0-100] L values.
+//The window statistics come from the table, so only the stretch itself reads the whole image
+void WindowStretchLuv(const Mat& Luv, Mat& stretchLuv, const MinMaxTable& L, double w1, double w2, double h1, double h2){
+	double min,max;
+
+	if(!isFloatImage(Luv)){
+		cout << "WARNING: Input Luv image type is not CV_32FC3 or CV_16FC3." << endl;
+		return void();
+	}
+	if(!checkMinMaxTable(L, Luv, 0)) return void();
+
+	L.minMax(windowRect(Luv.size(), w1, w2, h1, h2, 0), &min, &max);
+	stretchLuvRange(Luv, stretchLuv, min, max);
+return void();
+}
+
+//Function takes planar Luv image reference and window coordinates (w1,w2,h1,h2)
+//and updates planar stretchLuv image reference with linearly stretched [0-100] L values
+//using stretch values from window coordinates. The u and v planes are shared with the input
+void WindowStretchLuv(const PlanarImage& Luv, PlanarImage& stretchLuv, double w1, double w2, double h1, double h2){
+	double min,max;
+
+	if(!checkPlanar(Luv, "Luv")) return void();
+
+	windowMinMax(Luv.planes[0], 0, windowRect(Size(Luv.cols(), Luv.rows()), w1, w2, h1, h2, 0), &min, &max);
+
+	Mat L=outputPlane(Luv, stretchLuv, 0);
+	convertPixels<float,float>(Luv.planes[0], L, [min,max](const float& pixel){
+		return stretchValue(pixel, min, max, 100.0);
+	}, Luv.planes[0].type());
+	stretchLuv.planes[0]=L;
+	stretchLuv.planes[1]=Luv.planes[1];
+	stretchLuv.planes[2]=Luv.planes[2];
+
+return void();
+}
+
+//Function takes xyY Mat object reference and window coordinates (w1,w2,h1,h2)
+//and updates stretchxyY Mat object reference with linearly stretched [0-1] Y values
+//using stretch values from window coordinates
+void WindowStretchxyY(const Mat& xyY, Mat& stretchxyY, double w1, double w2, double h1, double h2){
+	double min,max;
+
+	if(!isFloatImage(xyY)){
+		cout << "WARNING: Input xyY image type is not CV_32FC3 or CV_16FC3." << endl;
+		return void();
+	}
+
+	windowMinMax(xyY, 2, windowRect(xyY.size(), w1, w2, h1, h2, 0), &min, &max);
+
+	//Copy x and y and stretch Y in a single pass
+	stretchxyYRange(xyY, stretchxyY, min, max);
+
+return void();
+}
+
+//Function takes xyY Mat object reference, a MinMaxTable built over its Y channel and window coordinates
+//(w1,w2,h1,h2) and updates stretchxyY Mat object reference with linearly stretched [0-1] Y values.
+//The window statistics come from the table, so only the stretch itself reads the whole image
+void WindowStretchxyY(const Mat& xyY, Mat& stretchxyY, const MinMaxTable& Y, double w1, double w2, double h1, double h2){
+	double min,max;
+
+	if(!isFloatImage(xyY)){
+		cout << "WARNING: Input xyY image type is not CV_32FC3 or CV_16FC3." << endl;
+		return void();
+	}
+	if(!checkMinMaxTable(Y, xyY, 2)) return void();
+
+	Y.minMax(windowRect(xyY.size(), w1, w2, h1, h2, 0), &min, &max);
+	stretchxyYRange(xyY, stretchxyY, min, max);
+return void();
+}
+
+//Function takes planar xyY image reference and window coordinates (w1,w2,h1,h2)
+//and updates planar stretchxyY image reference with linearly stretched [0-1] Y values
+//using stretch values from window coordinates. The x and y planes are shared with the input
+void WindowStretchxyY(const PlanarImage& xyY, PlanarImage& stretchxyY, double w1, double w2, double h1, double h2){
+	double min,max;
+
+	if(!checkPlanar(xyY, "xyY")) return void();
+
+	windowMinMax(xyY.planes[2], 0, windowRect(Size(xyY.cols(), xyY.rows()), w1, w2, h1, h2, 0), &min, &max);
+
+	Mat Y=outputPlane(xyY, stretchxyY, 2);
+	convertPixels<float,float>(xyY.planes[2], Y, [min,max](const float& pixel){
+		return stretchValue(pixel, min, max, 1.0);
+	}, xyY.planes[2].type());
+	stretchxyY.planes[0]=xyY.planes[0];
+	stretchxyY.planes[1]=xyY.planes[1];
+	stretchxyY.planes[2]=Y;
+
+return void();
+}
+
+//Function takes Luv Mat object reference and window coordinates (w1,w2,h1,h2)
+//and updates equLuv Mat object reference with histogram equalized [0-100] L values
+//using L values from window coordinates
+void LequLuv(const Mat& Luv, Mat& equLuv, double w1, double w2, double h1, double h2){
+	int pix_map[101];
+
+	if(!isFloatImage(Luv)){
+		cout << "WARNING: Input Luv image type is not CV_32FC3 or CV_16FC3." << endl;
+		return void();
+	}
+
+	//Size of the box is coordinates +1
+	equalizationMap(Luv, 0, windowRect(Luv.size(), w1, w2, h1, h2, 1), pix_map);
+
+	//Map L and copy u and v in a single pass
+	convertPixels<Vec3f,Vec3f>(Luv, equLuv, [&pix_map](const Vec3f& pixel){
+		return Vec3f(equalizeValue(pix_map, pixel[0]), pixel[1], pixel[2]);
+	}, Luv.type());
+return void();
+}
+
+//Function takes planar Luv image reference and window coordinates (w1,w2,h1,h2)
+//and updates planar equLuv image reference with histogram equalized [0-100] L values
+//using L values from window coordinates. The u and v planes are shared with the input
+void LequLuv(const PlanarImage& Luv, PlanarImage& equLuv, double w1, double w2, double h1, double h2){
+	int pix_map[101];
+
+	if(!checkPlanar(Luv, "Luv")) return void();
+
+	//Size of the box is coordinates +1
+	equalizationMap(Luv.planes[0], 0, windowRect(Size(Luv.cols(), Luv.rows()), w1, w2, h1, h2, 1), pix_map);
+
+	Mat L=outputPlane(Luv, equLuv, 0);
+	convertPixels<float,float>(Luv.planes[0], L, [&pix_map](const float& pixel){
+		return equalizeValue(pix_map, pixel);
+	}, Luv.planes[0].type());
+	equLuv.planes[0]=L;
+	equLuv.planes[1]=Luv.planes[1];
+	equLuv.planes[2]=Luv.planes[2];
+return void();
+}
+
+//Contrast limited adaptive equalization of L. The image is cut into a grid of tiles, every tile
+//gets its own equalization map from a clipped histogram of its L values, and every pixel blends
+//the maps of the four nearest tile centres bilinearly so no tile edges show. The maps are also
+//interpolated between integer L values, so unlike LequLuv the equalized L has no steps
+
+//Tile grid of an adaptive equalization. maps holds 101 float L values per tile in row major tile
+//order. Every column and row holds the two nearest tile centres and the weight of the second
+struct TileMaps {
+	int tilesX;
+	int tilesY;
+	vector<float> maps;
+	vector<int> column0, column1;
+	vector<float> columnWeight;
+	vector<int> row0, row1;
+	vector<float> rowWeight;
+};
+
+//Function returns the first pixel of tile t when size pixels are cut into tiles tiles
+static inline int tileStart(int size, int tiles, int t){
+	return (int)((int64)size*t/tiles);
+}
+
+//Function finds, for every pixel along one axis, the tiles whose centres are nearest on either
+//side and the weight of the second one. Pixels before the first or past the last centre use
+//that tile alone
+static void tileNeighbours(int size, int tiles, vector<int>& first, vector<int>& second, vector<float>& weight){
+	first.resize(size);
+	second.resize(size);
+	weight.resize(size);
+
+	int t=0;
+	for(int i = 0 ; i < size ; i++){
+		while(t+1 < tiles && (tileStart(size, tiles, t+1)+tileStart(size, tiles, t+2)-1)/2.0 <= i) t++;
+		double centre=(tileStart(size, tiles, t)+tileStart(size, tiles, t+1)-1)/2.0;
+		if(i<centre || t+1==tiles){
+			first[i]=t;
+			second[i]=t;
+			weight[i]=0.0f;
+		}else{
+			double next=(tileStart(size, tiles, t+1)+tileStart(size, tiles, t+2)-1)/2.0;
+			first[i]=t;
+			second[i]=t+1;
+			weight[i]=(float)((i-centre)/(next-centre));
+		}
+	}
+return void();
+}
+
+//Function builds the equalization map of one tile from its histogram. Bins above clipLimit times
+//the mean bin count are cut down and the excess is spread evenly over all bins, a clipLimit
+//of 0 keeps the histogram as it is. The map uses the same midpoint rule as equalizationMap
+//but keeps the fractional L values so neighbouring tiles blend smoothly
+static void clippedEqualizationMap(int hist[101], int area, double clipLimit, float* map){
+	if(clipLimit>0.0){
+		int limit=std::max((int)(clipLimit*area/101.0), 1);
+		int excess=0;
+		for(int i=0 ; i<101 ; i++){
+			if(hist[i]>limit){
+				excess+=hist[i]-limit;
+				hist[i]=limit;
+			}
+		}
+
+		//Spread the excess evenly and what is left over one bin in every step bins
+		int each=excess/101;
+		int left=excess%101;
+		for(int i=0 ; i<101 ; i++) hist[i]+=each;
+		if(left>0){
+			int step=std::max(101/left, 1);
+			for(int i=0 ; i<101 && left>0 ; i+=step, left--) hist[i]++;
+		}
+	}
+
+	int previous=0;
+	int accum=0;
+	for(int i=0 ; i<101 ; i++){
+		accum+=hist[i];
+		map[i]=(float)(((previous+accum)/2.0)*(100.0/std::max(area, 1)));
+		previous=accum;
+	}
+return void();
+}
+
+//Function checks the tile grid and clip limit of an adaptive equalization, returns false with a warning when they don't fit the image
+static bool checkTiles(const Mat& Luv, int tilesX, int tilesY, double clipLimit){
+	if(!isFloatImage(Luv)){
+		cout << "WARNING: Input Luv image type is not CV_32FC3 or CV_16FC3." << endl;
+		return false;
+	}
+	if(tilesX<1 || tilesY<1 || tilesX>Luv.cols || tilesY>Luv.rows){
+		cout << "WARNING: Tile grid " << tilesX << "x" << tilesY << " does not fit a "
+		     << Luv.cols << "x" << Luv.rows << " image." << endl;
+		return false;
+	}
+	if(clipLimit<0.0){
+		cout << "WARNING: Clip limit must not be negative." << endl;
+		return false;
+	}
+	return true;
+}
+
+//Function computes the maps of every tile of a Luv image. Tiles are spread over the conversion
+//threads and each tile counts its histogram on a single thread
+static void computeTileMaps(const Mat& Luv, int tilesX, int tilesY, double clipLimit, TileMaps& tiles){
+	int count=tilesX*tilesY;
+
+	tiles.tilesX=tilesX;
+	tiles.tilesY=tilesY;
+	tiles.maps.assign(count*101, 0.0f);
+	tileNeighbours(Luv.cols, tilesX, tiles.column0, tiles.column1, tiles.columnWeight);
+	tileNeighbours(Luv.rows, tilesY, tiles.row0, tiles.row1, tiles.rowWeight);
+
+	forEachStripe(count, std::min(stripeCount((double)Luv.total()), count), [&](int, int start, int end){
+		for(int t = start ; t < end ; t++){
+			int tx=t%tilesX;
+			int ty=t/tilesX;
+			Rect tile(tileStart(Luv.cols, tilesX, tx), tileStart(Luv.rows, tilesY, ty), 0, 0);
+			tile.width=tileStart(Luv.cols, tilesX, tx+1)-tile.x;
+			tile.height=tileStart(Luv.rows, tilesY, ty+1)-tile.y;
+
+			int hist[101];
+			for(int k = 0 ; k < 101 ; k++) hist[k] = 0;
+			accumulateHistogram(Luv, 0, tile, hist, 1);
+			clippedEqualizationMap(hist, tile.width*tile.height, clipLimit, &tiles.maps[t*101]);
+		}
+	});
+return void();
+}
+
+//Function returns a tile map at bin+fraction, interpolated between the two neighbouring bins
+static inline float mapValue(const float* maps, int bin, float fraction){
+	return maps[bin]+(maps[bin+1]-maps[bin])*fraction;
+}
+
+//Function equalizes L of every pixel of a Luv image through the tile maps, one block of a row
+//at a time, and hands each block to store(row, x, pixels, count)
+template<typename StoreBlock>
+static void applyTileMaps(const Mat& Luv, const TileMaps& tiles, StoreBlock store){
+	forEachStripe(Luv.rows, std::min(stripeCount((double)Luv.total()), Luv.rows), [&](int, int start, int end){
+		float buffer[3*blockSize];
+		Vec3f pixels[blockSize];
+
+		for(int j = start ; j < end ; j++){
+			const float* top=&tiles.maps[tiles.row0[j]*tiles.tilesX*101];
+			const float* bottom=&tiles.maps[tiles.row1[j]*tiles.tilesX*101];
+			float rowWeight=tiles.rowWeight[j];
+
+			for(int x = 0 ; x < Luv.cols ; x += blockSize){
+				int count=std::min(blockSize, Luv.cols-x);
+				const Vec3f* input=(const Vec3f*)floatPixels(Luv, j, x, count, buffer);
+
+				for(int i = 0 ; i < count ; i++){
+					float L=std::min(std::max(input[i][0], 0.0f), 99.999f);
+					int bin=(int)L;
+					float fraction=L-bin;
+					int left=tiles.column0[x+i]*101+bin;
+					int right=tiles.column1[x+i]*101+bin;
+					float weight=tiles.columnWeight[x+i];
+					float upper=mapValue(top, left, fraction)+(mapValue(top, right, fraction)-mapValue(top, left, fraction))*weight;
+					float lower=mapValue(bottom, left, fraction)+(mapValue(bottom, right, fraction)-mapValue(bottom, left, fraction))*weight;
+					pixels[i]=Vec3f(upper+(lower-upper)*rowWeight, input[i][1], input[i][2]);
+				}
+				store(j, x, pixels, count);
+			}
+		}
+	});
+return void();
+}
+
+//Function takes Luv Mat object reference and updates equLuv Mat object reference with L
+//equalized by contrast limited adaptive histogram equalization over a tilesX x tilesY grid.
+//clipLimit caps every tile histogram bin at clipLimit times the mean bin count, 0 turns clipping off
+void AdaptiveLequLuv(const Mat& Luv, Mat& equLuv, int tilesX, int tilesY, double clipLimit){
+	TileMaps tiles;
+
+	if(!checkTiles(Luv, tilesX, tilesY, clipLimit)) return void();
+	computeTileMaps(Luv, tilesX, tilesY, clipLimit, tiles);
+
+	//Every block is read before it is written, so equLuv may be Luv
+	Mat source=Luv;
+	equLuv.create(source.rows, source.cols, source.type());
+	bool halfOutput=equLuv.depth()==CV_16F;
+	applyTileMaps(source, tiles, [&equLuv,halfOutput](int j, int x, const Vec3f* pixels, int count){
+		if(halfOutput) floatToHalfRow()((const float*)pixels, equLuv.ptr<ushort>(j)+3*x, 3*count);
+		else std::copy(pixels, pixels+count, equLuv.ptr<Vec3f>(j)+x);
+	});
+return void();
+}
+
+//Function takes Luv Mat object reference and updates non-linear scaled [0-255] RGB Mat object
+//reference with L adaptively equalized as in AdaptiveLequLuv, in a single pass.
+//Equivalent to AdaptiveLequLuv and LuvtonsRGB run back to back, the equalized Luv block goes
+//straight through XYZ and lRGB
+void AdaptiveLequLuvtonsRGB(const Mat& Luv, Mat& nsRGB, int tilesX, int tilesY, double clipLimit){
+	TileMaps tiles;
+
+	if(!checkTiles(Luv, tilesX, tilesY, clipLimit)) return void();
+	computeTileMaps(Luv, tilesX, tilesY, clipLimit, tiles);
+
+	const float* thresholds=gammaThresholds();
+	MatrixRowFunc matrix=matrixRow();
+	Mat source=Luv;
+	nsRGB.create(source.rows, source.cols, CV_8UC3);
+	applyTileMaps(source, tiles, [&nsRGB,thresholds,matrix](int j, int x, const Vec3f* pixels, int count){
+		Vec3f buffer[blockSize];
+		for(int i = 0 ; i < count ; i++) buffer[i]=LuvtoXYZPixel(pixels[i]);
+		XYZtonsRGBBlock(thresholds, matrix, buffer, nsRGB.ptr<Vec3b>(j)+x, count);
+	});
+return void();
+}
+
+//Function takes non-linear scaled [0-255] RGB Mat object reference and a list of windows, converts the
+//image to Luv, or to xyY for batchStretchY, once and updates one non-linear scaled [0-255] RGB output per
+//window. Every output matches the single window flow: WindowStretchLuv, LequLuv or WindowStretchxyY
+//between the forward conversion and the single pass return to nsRGB.
+//Window statistics are taken first, stretches read theirs from one MinMaxTable. The remaps and return
+//paths of all windows then run as one parallel loop over stripes of rows of every output
+void BatchWindows(const Mat& nsRGB, BatchOperation operation, const vector<StretchWindow>& windows, vector<Mat>& outputs){
+	if(nsRGB.type()!=CV_8UC3){
+		cout << "WARNING: Input nsRGB image type is not CV_8UC3." << endl;
+		return void();
+	}
+	int count=(int)windows.size();
+	bool xyY=operation==batchStretchY;
+	outputs.resize(count);
+	if(count==0) return void();
+
+	Mat forward;
+	if(xyY) nsRGBtoxyY(nsRGB, forward);
+	else nsRGBtoLuv(nsRGB, forward);
+
+	//Stretch ranges or equalization maps of every window
+	vector<double> low(count), high(count);
+	vector<int> pix_maps(count*101);
+	MinMaxTable table;
+	if(operation==batchEqualizeL){
+		//Size of the box is coordinates +1
+		for(int w = 0 ; w < count ; w++){
+			const StretchWindow& c=windows[w];
+			equalizationMap(forward, 0, windowRect(forward.size(), c.w1, c.w2, c.h1, c.h2, 1), &pix_maps[w*101]);
+		}
+	}else{
+		table.build(forward, xyY ? 2 : 0);
+		for(int w = 0 ; w < count ; w++){
+			const StretchWindow& c=windows[w];
+			table.minMax(windowRect(forward.size(), c.w1, c.w2, c.h1, c.h2, 0), &low[w], &high[w]);
+		}
+	}
+
+	for(int w = 0 ; w < count ; w++) outputs[w].create(nsRGB.rows, nsRGB.cols, CV_8UC3);
+
+	const float* thresholds=gammaThresholds();
+	MatrixRowFunc matrix=matrixRow();
+	int stripes=std::min(stripeCount((double)nsRGB.total()), std::max(nsRGB.rows, 1));
+	forEachStripe(count*stripes, count*stripes, [&](int task, int, int){
+		int w=task/stripes;
+		int s=task%stripes;
+		const int* pix_map=&pix_maps[w*101];
+		float buffer[3*blockSize];
+		Vec3f pixels[blockSize];
+
+		for(int j = (int)((int64)forward.rows*s/stripes) ; j < (int)((int64)forward.rows*(s+1)/stripes) ; j++){
+			for(int x = 0 ; x < forward.cols ; x += blockSize){
+				int n=std::min(blockSize, forward.cols-x);
+				const Vec3f* input=(const Vec3f*)floatPixels(forward, j, x, n, buffer);
+
+				for(int i = 0 ; i < n ; i++){
+					Vec3f pixel=input[i];
+					if(operation==batchStretchL) pixel[0]=stretchValue(pixel[0], low[w], high[w], 100.0);
+					if(operation==batchEqualizeL) pixel[0]=equalizeValue(pix_map, pixel[0]);
+					if(operation==batchStretchY) pixel[2]=stretchValue(pixel[2], low[w], high[w], 1.0);
+					pixels[i]=xyY ? xyYtoXYZPixel(pixel) : LuvtoXYZPixel(pixel);
+				}
+				XYZtonsRGBBlock(thresholds, matrix, pixels, outputs[w].ptr<Vec3b>(j)+x, n);
+			}
+		}
+	});
+return void();
+}
+
+//Fixed point scales of the 8 bit pipeline, linear RGB holds 1.0 as 32767 and XYZ holds 1.0 as 16384
+static const int lRGBFixedOne=32767;
+static const int XYZFixedOne=16384;
+
+//Fixed point 3x3 color matrix on 16 bit values. Each output value is
+//clamp((sum of m*input + 2^(shift-1)) >> shift, low, high), the products are summed in 32 bits
+struct FixedMatrix {
+	short m[9];
+	int shift;
+	short low;
+	short high;
+
+	FixedMatrix(const double* matrix, double scale, int shift, short low, short high) : shift(shift), low(low), high(high){
+		for(int k = 0 ; k < 9 ; k++) m[k]=(short)lrint(matrix[k]*scale*(1<<shift));
+	}
+};
+
+//Function applies a fixed point color matrix to n pixels held in three planes of 16 bit values.
+//Input and output planes may be the same
+static void fixedMatrixScalar(const FixedMatrix& m, const short* const* input, short* const* output, int n){
+	for(int i = 0 ; i < n ; i++){
+		int a=input[0][i];
+		int b=input[1][i];
+		int c=input[2][i];
+
+		for(int r = 0 ; r < 3 ; r++){
+			int sum=(a*m.m[3*r]+b*m.m[3*r+1]+c*m.m[3*r+2]+(1<<(m.shift-1)))>>m.shift;
+			sum=std::min(std::max(sum, (int)m.low), (int)m.high);
+			output[r][i]=(short)sum;
+		}
+	}
+}
+
+//Function applies a fixed point color matrix to one pixel of values too large for 16 bits,
+//with 64 bit sums, and stores the clamped result at position i of the output planes
+static inline void fixedMatrixWide(const FixedMatrix& m, const int64_t* input, short* const* output, int i){
+	for(int r = 0 ; r < 3 ; r++){
+		int64_t sum=(input[0]*m.m[3*r]+input[1]*m.m[3*r+1]+input[2]*m.m[3*r+2]+(1<<(m.shift-1)))>>m.shift;
+		sum=std::min(std::max(sum, (int64_t)m.low), (int64_t)m.high);
+		output[r][i]=(short)sum;
+	}
+return void();
+}
+
+#ifdef COLOR_CONVERSIONS_X86_SIMD
+//SSE2 matrix kernel, 8 pixels per instruction in 16 bit lanes. pmaddwd multiplies the
+//interleaved (a,b) and (c,0) pairs by (m0,m1) and (m2,0) and sums each pair in 32 bits,
+//so every result matches fixedMatrixScalar
+__attribute__((target("sse2")))
+static void fixedMatrixSSE2(const FixedMatrix& m, const short* const* input, short* const* output, int n){
+	const __m128i zero=_mm_setzero_si128();
+	const __m128i round=_mm_set1_epi32(1<<(m.shift-1));
+	const __m128i shift=_mm_cvtsi32_si128(m.shift);
+	const __m128i low=_mm_set1_epi16(m.low);
+	const __m128i high=_mm_set1_epi16(m.high);
+	__m128i ab[3];
+	__m128i c0[3];
+
+	for(int r = 0 ; r < 3 ; r++){
+		ab[r]=_mm_set1_epi32((int)(ushort)m.m[3*r] | ((int)(ushort)m.m[3*r+1] << 16));
+		c0[r]=_mm_set1_epi32((int)(ushort)m.m[3*r+2]);
+	}
+
+	int i=0;
+	for( ; i+8 <= n ; i += 8){
+		__m128i a=_mm_loadu_si128((const __m128i*)(input[0]+i));
+		__m128i b=_mm_loadu_si128((const __m128i*)(input[1]+i));
+		__m128i c=_mm_loadu_si128((const __m128i*)(input[2]+i));
+		__m128i abLow=_mm_unpacklo_epi16(a, b);
+		__m128i abHigh=_mm_unpackhi_epi16(a, b);
+		__m128i cLow=_mm_unpacklo_epi16(c, zero);
+		__m128i cHigh=_mm_unpackhi_epi16(c, zero);
+
+		for(int r = 0 ; r < 3 ; r++){
+			__m128i sumLow=_mm_add_epi32(_mm_madd_epi16(abLow, ab[r]), _mm_madd_epi16(cLow, c0[r]));
+			__m128i sumHigh=_mm_add_epi32(_mm_madd_epi16(abHigh, ab[r]), _mm_madd_epi16(cHigh, c0[r]));
+			sumLow=_mm_sra_epi32(_mm_add_epi32(sumLow, round), shift);
+			sumHigh=_mm_sra_epi32(_mm_add_epi32(sumHigh, round), shift);
+			__m128i result=_mm_packs_epi32(sumLow, sumHigh);
+			result=_mm_min_epi16(_mm_max_epi16(result, low), high);
+			_mm_storeu_si128((__m128i*)(output[r]+i), result);
+		}
+	}
+
+	const short* inputTail[3]={input[0]+i, input[1]+i, input[2]+i};
+	short* outputTail[3]={output[0]+i, output[1]+i, output[2]+i};
+	fixedMatrixScalar(m, inputTail, outputTail, n-i);
+}
+#endif
+
+typedef void (*FixedMatrixFunc)(const FixedMatrix& m, const short* const* input, short* const* output, int n);
+
+//Function picks the fastest fixed point matrix kernel the CPU running the program supports
+static FixedMatrixFunc selectFixedMatrix(){
+#ifdef COLOR_CONVERSIONS_X86_SIMD
+	if(checkHardwareSupport(CV_CPU_SSE2)) return fixedMatrixSSE2;
+#endif
+	return fixedMatrixScalar;
+}
+
+//Function returns the fixed point matrix kernel, selected once on first use
+static FixedMatrixFunc fixedMatrix(){
+	static const FixedMatrixFunc func=selectFixedMatrix();
+	return func;
+}
+
+//Function rounds a float value to fixed point steps, NaN from an empty stretch range gives 0
+static inline int toFixed(float value, int one){
+	if(value!=value) return 0;
+	return (int)lrint(value*one);
+}
+
+//Lookup tables and matrices of the fixed point pipeline. Table entries are computed once with
+//the float conversions, so each entry matches the float result for the value it stands for
+struct FixedTables {
+	short lRGB[256];
+	uchar nsRGB[lRGBFixedOne+1];
+	short L[XYZFixedOne+1];
+	short Y[100*LuvFixedOne+1];
+	FixedMatrix toXYZ;
+	FixedMatrix tolRGB;
+	//uw and vw with 14 fractional bits
+	int uw14;
+	int vw14;
+	//13 times uw and vw with 8 fractional bits
+	int uw13;
+	int vw13;
+
+	FixedTables() :
+		toXYZ(lRGBtoXYZMatrix, (double)XYZFixedOne/lRGBFixedOne, 16, 0, 32767),
+		tolRGB(XYZtolRGBMatrix, (double)lRGBFixedOne/XYZFixedOne, 12, 0, lRGBFixedOne){
+		const float* table=invgammaTable();
+		for(int k = 0 ; k < 256 ; k++) lRGB[k]=(short)toFixed(table[k], lRGBFixedOne);
+
+		const float* thresholds=gammaThresholds();
+		for(int k = 0 ; k <= lRGBFixedOne ; k++) nsRGB[k]=lRGBtonsRGBValue(thresholds, (float)k/lRGBFixedOne);
+
+		for(int k = 0 ; k <= XYZFixedOne ; k++){
+			float value=(float)k/XYZFixedOne;
+			L[k]=(short)toFixed(XYZtoLuvPixel<cubeRoot>(Vec3f(value,value,value))[0], LuvFixedOne);
+		}
+		for(int k = 0 ; k <= 100*LuvFixedOne ; k++){
+			float value=(float)k/LuvFixedOne;
+			Y[k]=(short)toFixed(LuvtoXYZPixel(Vec3f(value,0.0f,0.0f))[1], XYZFixedOne);
+		}
+
+		uw14=(int)lrint(uw*(1<<14));
+		vw14=(int)lrint(vw*(1<<14));
+		uw13=(int)lrint(13.0*uw*(1<<8));
+		vw13=(int)lrint(13.0*vw*(1<<8));
+	}
+};
+
+//Function returns the fixed point tables, built on first use
+static const FixedTables& fixedTables(){
+	static const FixedTables tables;
+	return tables;
+}
+
+//Function converts a block of non-linear scaled [0-255] byte RGB pixels to fixed point XYZ
+//held in three planes, with the lRGB lookup table and the fixed point matrix kernel
+static inline void nsRGBtoXYZFixedBlock(const FixedTables& tables, FixedMatrixFunc matrix, const Vec3b* input, short* const* planes, int count){
+	for(int i = 0 ; i < count ; i++){
+		planes[0][i]=tables.lRGB[input[i][0]];
+		planes[1][i]=tables.lRGB[input[i][1]];
+		planes[2][i]=tables.lRGB[input[i][2]];
+	}
+	matrix(tables.toXYZ, planes, planes, count);
+}
+
+//Function converts a single fixed point XYZ pixel to a fixed point Luv pixel,
+//uprime and vprime are found with 14 fractional bits
+static inline Vec3s XYZtoLuvFixedPixel(const FixedTables& tables, int X, int Y, int Z){
+	Y=std::min(Y, XYZFixedOne);
+	int L=tables.L[Y];
+	uint32_t d=X+15*Y+3*Z;
+
+	if(L==0 || d==0) return Vec3s((short)L, 0, 0);
+
+	int uprime=(int)(((uint32_t)(4*X)<<14)/d);
+	int vprime=(int)(((uint32_t)(9*Y)<<14)/d);
+	int u=(int)(((int64_t)13*L*(uprime-tables.uw14)+(1<<13))>>14);
+	int v=(int)(((int64_t)13*L*(vprime-tables.vw14)+(1<<13))>>14);
+	return Vec3s((short)L, saturate_cast<short>(u), saturate_cast<short>(v));
+}
+
+//Function converts a single fixed point XYZ pixel to a fixed point xyY pixel
+static inline Vec3w XYZtoxyYFixedPixel(int X, int Y, int Z){
+	uint32_t sum=X+Y+Z;
+
+	if(sum==0) return Vec3w(0, 0, 0);
+
+	ushort x=(ushort)((((uint32_t)X<<15)+sum/2)/sum);
+	ushort y=(ushort)((((uint32_t)Y<<15)+sum/2)/sum);
+	return Vec3w(x, y, (ushort)std::min(2*Y, xyYFixedOne));
+}
+
+//Function takes non-linear scaled [0-255] byte (uint) RGB Mat object reference
+//and updates fixed point Luv Mat object reference in a single pass.
+//While a table is loaded each pixel is a single lookup
+void nsRGBtoLuvFixed(const Mat& nsRGB, Mat& Luv){
+	if(nsRGB.type()!=CV_8UC3){
+		cout << "WARNING: Input nsRGB image type is not CV_8UC3." << endl;
+		return void();
+	}
+	if(luvTable){
+		const Vec3s* lookup=luvTable;
+		convertPixels<Vec3b,Vec3s>(nsRGB, Luv, [lookup](const Vec3b& pixel){ return lookup[luvTableIndex(pixel)]; });
+		return void();
+	}
+	const FixedTables& tables=fixedTables();
+	FixedMatrixFunc matrix=fixedMatrix();
+
+	convertRows<Vec3b,Vec3s>(nsRGB, Luv, [&tables,matrix](const Vec3b* inputRow, Vec3s* outputRow, int n){
+		short block[3][blockSize];
+		short* planes[3]={block[0], block[1], block[2]};
+
+		for(int start = 0 ; start < n ; start += blockSize){
+			int count = std::min(blockSize, n-start);
+
+			nsRGBtoXYZFixedBlock(tables, matrix, inputRow+start, planes, count);
+			for(int i = 0 ; i < count ; i++) outputRow[start+i]=XYZtoLuvFixedPixel(tables, block[0][i], block[1][i], block[2][i]);
+		}
+	});
+return void();
+}
+
+//Function takes non-linear scaled [0-255] byte (uint) RGB Mat object reference
+//and updates fixed point xyY Mat object reference in a single pass
+void nsRGBtoxyYFixed(const Mat& nsRGB, Mat& xyY){
+	if(nsRGB.type()!=CV_8UC3){
+		cout << "WARNING: Input nsRGB image type is not CV_8UC3." << endl;
+		return void();
+	}
+	const FixedTables& tables=fixedTables();
+	FixedMatrixFunc matrix=fixedMatrix();
+
+	convertRows<Vec3b,Vec3w>(nsRGB, xyY, [&tables,matrix](const Vec3b* inputRow, Vec3w* outputRow, int n){
+		short block[3][blockSize];
+		short* planes[3]={block[0], block[1], block[2]};
+
+		for(int start = 0 ; start < n ; start += blockSize){
+			int count = std::min(blockSize, n-start);
+
+			nsRGBtoXYZFixedBlock(tables, matrix, inputRow+start, planes, count);
+			for(int i = 0 ; i < count ; i++) outputRow[start+i]=XYZtoxyYFixedPixel(block[0][i], block[1][i], block[2][i]);
+		}
+	});
+return void();
+}
+
+//Function divides a non-negative fixed point numerator by a positive denominator with rounding,
+//negative numerators give 0
+static inline int64_t divideXYZ(int64_t numerator, int64_t denominator){
+	if(numerator<=0) return 0;
+	return (numerator+denominator/2)/denominator;
+}
+
+//Fixed point XYZ values of a pixel in a block that are too large for the 16 bit planes. Colors far
+//outside the gamut, with vprime or y close to 0, reach X or Z of several times 1.0
+struct WideXYZ {
+	int index;
+	int64_t XYZ[3];
+};
+
+//Function stores fixed point XYZ values at position i of three 16 bit planes and returns false
+//when one of them is above the 16 bit range, the planes then hold clamped values
+static inline bool storeXYZFixed(const int64_t* XYZ, short* const* planes, int i){
+	bool fits=true;
+
+	for(int c = 0 ; c < 3 ; c++){
+		planes[c][i]=(short)std::min(XYZ[c], (int64_t)32767);
+		fits&=XYZ[c]<=32767;
+	}
+	return fits;
+}
+
+//Function converts a single fixed point Luv pixel to fixed point XYZ values. The 13*L factors
+//of uprime and vprime cancel in X and Z, which are found from a = 256*(u + 13*uw*L)
+//and b = 256*(v + 13*vw*L) with one division each
+static inline void LuvtoXYZFixedPixel(const FixedTables& tables, const Vec3s& Luvval, int64_t* XYZ){
+	int L=std::min((int)Luvval[0], 100*LuvFixedOne);
+
+	XYZ[0]=0;
+	XYZ[1]=0;
+	XYZ[2]=0;
+	if(L<=0) return void();
+
+	int64_t y=tables.Y[L];
+	int64_t a=(int64_t)Luvval[1]*256+(int64_t)tables.uw13*L;
+	int64_t b=(int64_t)Luvval[2]*256+(int64_t)tables.vw13*L;
+	int64_t k=(int64_t)13*256*L;
+
+	XYZ[1]=y;
+	//vprime below 0.001 gives X=Z=0 as in the float conversion
+	if(b*1000<k) return void();
+
+	XYZ[0]=divideXYZ(9*y*a, 4*b);
+	XYZ[2]=divideXYZ(y*(12*k-3*a-20*b), 4*b);
+return void();
+}
+
+//Function converts a single fixed point xyY pixel to fixed point XYZ values
+static inline void xyYtoXYZFixedPixel(const Vec3w& xyYval, int64_t* XYZ){
+	int64_t x=xyYval[0];
+	int64_t y=xyYval[1];
+	int64_t Yval=xyYval[2];
+
+	XYZ[0]=0;
+	XYZ[1]=0;
+	XYZ[2]=0;
+	if(y==0) return void();
+
+	XYZ[0]=divideXYZ(x*Yval, 2*y);
+	XYZ[1]=(Yval+1)>>1;
+	XYZ[2]=divideXYZ((xyYFixedOne-x-y)*Yval, 2*y);
+return void();
+}
+
+//Function converts a block of fixed point XYZ values held in three planes to non-linear
+//scaled [0-255] byte RGB pixels with the fixed point matrix kernel and the nsRGB lookup table,
+//the planes are overwritten with lRGB. Pixels whose XYZ values were too large for the planes
+//are converted again from their full values, so they clip per channel like the float conversion
+static inline void XYZtonsRGBFixedBlock(const FixedTables& tables, FixedMatrixFunc matrix, short* const* planes, const WideXYZ* wide, int wideCount, Vec3b* output, int count){
+	matrix(tables.tolRGB, planes, planes, count);
+	for(int w = 0 ; w < wideCount ; w++) fixedMatrixWide(tables.tolRGB, wide[w].XYZ, planes, wide[w].index);
+	for(int i = 0 ; i < count ; i++){
+		output[i]=Vec3b(tables.nsRGB[planes[0][i]], tables.nsRGB[planes[1][i]], tables.nsRGB[planes[2][i]]);
+	}
+}
+
+//Function takes fixed point Luv Mat object reference and updates non-linear scaled [0-255]
+//byte RGB Mat object reference in a single pass
+void LuvFixedtonsRGB(const Mat& Luv, Mat& nsRGB){
+	if(Luv.type()!=CV_16SC3){
+		cout << "WARNING: Input Luv image type is not CV_16SC3." << endl;
+		return void();
+	}
+	const FixedTables& tables=fixedTables();
+	FixedMatrixFunc matrix=fixedMatrix();
+
+	convertRows<Vec3s,Vec3b>(Luv, nsRGB, [&tables,matrix](const Vec3s* inputRow, Vec3b* outputRow, int n){
+		short block[3][blockSize];
+		short* planes[3]={block[0], block[1], block[2]};
+		WideXYZ wide[blockSize];
+
+		for(int start = 0 ; start < n ; start += blockSize){
+			int count = std::min(blockSize, n-start);
+			int wideCount=0;
+
+			for(int i = 0 ; i < count ; i++){
+				WideXYZ& pixel=wide[wideCount];
+				LuvtoXYZFixedPixel(tables, inputRow[start+i], pixel.XYZ);
+				pixel.index=i;
+				if(!storeXYZFixed(pixel.XYZ, planes, i)) wideCount++;
+			}
+			XYZtonsRGBFixedBlock(tables, matrix, planes, wide, wideCount, outputRow+start, count);
+		}
+	});
+return void();
+}
+
+//Function takes fixed point xyY Mat object reference and updates non-linear scaled [0-255]
+//byte RGB Mat object reference in a single pass
+void xyYFixedtonsRGB(const Mat& xyY, Mat& nsRGB){
+	if(xyY.type()!=CV_16UC3){
+		cout << "WARNING: Input xyY image type is not CV_16UC3." << endl;
+		return void();
+	}
+	const FixedTables& tables=fixedTables();
+	FixedMatrixFunc matrix=fixedMatrix();
+
+	convertRows<Vec3w,Vec3b>(xyY, nsRGB, [&tables,matrix](const Vec3w* inputRow, Vec3b* outputRow, int n){
+		short block[3][blockSize];
+		short* planes[3]={block[0], block[1], block[2]};
+		WideXYZ wide[blockSize];
+
+		for(int start = 0 ; start < n ; start += blockSize){
+			int count = std::min(blockSize, n-start);
+			int wideCount=0;
+
+			for(int i = 0 ; i < count ; i++){
+				WideXYZ& pixel=wide[wideCount];
+				xyYtoXYZFixedPixel(inputRow[start+i], pixel.XYZ);
+				pixel.index=i;
+				if(!storeXYZFixed(pixel.XYZ, planes, i)) wideCount++;
+			}
+			XYZtonsRGBFixedBlock(tables, matrix, planes, wide, wideCount, outputRow+start, count);
+		}
+	});
+return void();
+}
+
+//Function builds the remap table of fixed point L values from a remap of [0-100] float L values
+template<typename Remap>
+static vector<short> remapTableL(Remap remap){
+	vector<short> table(100*LuvFixedOne+1);
+
+	for(int k = 0 ; k <= 100*LuvFixedOne ; k++) table[k]=(short)toFixed(remap((float)k/LuvFixedOne), LuvFixedOne);
+	return table;
+}
+
+//Function remaps L of a fixed point Luv image through a table indexed by fixed point L,
+//u and v are copied
+static void remapLFixed(const Mat& Luv, Mat& remapLuv, const vector<short>& table){
+	const short* map=&table[0];
+
+	convertPixels<Vec3s,Vec3s>(Luv, remapLuv, [map](const Vec3s& pixel){
+		int L=std::min(std::max((int)pixel[0], 0), 100*LuvFixedOne);
+		return Vec3s(map[L], pixel[1], pixel[2]);
+	});
+return void();
+}
+
+//Function takes fixed point Luv Mat object reference and window coordinates (w1,w2,h1,h2)
+//and updates stretchLuv Mat object reference with linearly stretched [0-100] L values
+//using stretch values from window coordinates
+void WindowStretchLuvFixed(const Mat& Luv, Mat& stretchLuv, double w1, double w2, double h1, double h2){
+	double min,max;
+
+	if(Luv.type()!=CV_16SC3){
+		cout << "WARNING: Input Luv image type is not CV_16SC3." << endl;
+		return void();
+	}
+
+	windowMinMax(Luv, 0, windowRect(Luv.size(), w1, w2, h1, h2, 0), &min, &max);
+
+	remapLFixed(Luv, stretchLuv, remapTableL([min,max](float L){ return stretchValue(L, min, max, 100.0); }));
+return void();
+}
+
+//Function takes fixed point Luv Mat object reference and window coordinates (w1,w2,h1,h2)
+//and updates equLuv Mat object reference with histogram equalized [0-100] L values
+//using L values from window coordinates
+void LequLuvFixed(const Mat& Luv, Mat& equLuv, double w1, double w2, double h1, double h2){
+	int pix_map[101];
+
+	if(Luv.type()!=CV_16SC3){
+		cout << "WARNING: Input Luv image type is not CV_16SC3." << endl;
+		return void();
+	}
+
+	//Size of the box is coordinates +1
+	equalizationMap(Luv, 0, windowRect(Luv.size(), w1, w2, h1, h2, 1), pix_map);
+
+	remapLFixed(Luv, equLuv, remapTableL([&pix_map](float L){ return equalizeValue(pix_map, L); }));
+return void();
+}
+
+//Function takes fixed point xyY Mat object reference and window coordinates (w1,w2,h1,h2)
+//and updates stretchxyY Mat object reference with linearly stretched [0-1] Y values
+//using stretch values from window coordinates
+void WindowStretchxyYFixed(const Mat& xyY, Mat& stretchxyY, double w1, double w2, double h1, double h2){
+	double min,max;
+
+	if(xyY.type()!=CV_16UC3){
+		cout << "WARNING: Input xyY image type is not CV_16UC3." << endl;
+		return void();
+	}
+
+	windowMinMax(xyY, 2, windowRect(xyY.size(), w1, w2, h1, h2, 0), &min, &max);
+
+	vector<ushort> table(xyYFixedOne+1);
+	for(int k = 0 ; k <= xyYFixedOne ; k++){
+		table[k]=(ushort)toFixed(stretchValue((float)k/xyYFixedOne, min, max, 1.0), xyYFixedOne);
+	}
+
+	const ushort* map=&table[0];
+	convertPixels<Vec3w,Vec3w>(xyY, stretchxyY, [map](const Vec3w& pixel){
+		return Vec3w(pixel[0], pixel[1], map[std::min((int)pixel[2], xyYFixedOne)]);
+	});
+return void();
+}
+
+//Error bound of the 3D lookup table conversions in 8 bit levels
+static double lutErrorBound=2.0;
+
+//Function sets the error bound, in 8 bit levels, that 99 percent of the checked colors of a 3D lookup table must meet
+void setLutErrorBound(double levels){
+	lutErrorBound=levels;
+}
+
+//Function returns the error bound of the 3D lookup table conversions
+double getLutErrorBound(){
+	return lutErrorBound;
+}
+
+//Function converts a vector of non-linear [0-1] RGB pixels in place through linear RGB, XYZ, Luv with
+//an L remap and back to non-linear [0-255] RGB floats, as the staged float conversions do.
+//The pixels are split into stripes run on separate threads and converted in blocks
+template<typename Remap>
+static void remapChain(const Remap& remap, vector<Vec3f>& pixels){
+	MatrixRowFunc matrix=matrixRow();
+	bool fast=useFastMath();
+	int n=(int)pixels.size();
+
+	forEachStripe(n, std::min(stripeCount(n), std::max(n, 1)), [&](int, int start, int end){
+		for(int first = start ; first < end ; first += blockSize){
+			int count=std::min(blockSize, end-first);
+			Vec3f* block=&pixels[first];
+
+			if(fast) curveRow<fastInvgamma>(block, block, count);
+			else curveRow<invgamma>(block, block, count);
+			matrix(lRGBtoXYZMatrix, false, block, block, count);
+			XYZtoLuvBlock(fast, block, count);
+			for(int i = 0 ; i < count ; i++){
+				block[i][0]=remap(block[i][0]);
+				block[i]=LuvtoXYZPixel(block[i]);
+			}
+			matrix(XYZtolRGBMatrix, true, block, block, count);
+			if(fast) curveRow<fastGamma>(block, block, count);
+			else curveRow<gamma>(block, block, count);
+			for(int i = 0 ; i < 3*count ; i++) block->val[i]*=255.0f;
+		}
+	});
+return void();
+}
+
+//Per-image 3D lookup table of a whole nsRGB to nsRGB conversion, sampled on a size^3 lattice evenly
+//spaced over the non-linear RGB cube. Nodes hold non-linear [0-255] RGB floats, red is the slowest index
+struct RemapLUT {
+	//Number of random colors the error of a table is checked at
+	static const int checks=32768;
+
+	int size;
+	vector<Vec3f> nodes;
+	//Lattice cell and position inside the cell of each byte value
+	int cell[256];
+	float fraction[256];
+
+	template<typename Remap>
+	RemapLUT(int size, const Remap& remap) : size(size), nodes(size*size*size){
+		for(int r = 0 ; r < size ; r++){
+			for(int g = 0 ; g < size ; g++){
+				for(int b = 0 ; b < size ; b++){
+					nodes[(r*size+g)*size+b]=Vec3f((float)r/(size-1), (float)g/(size-1), (float)b/(size-1));
+				}
+			}
+		}
+		remapChain(remap, nodes);
+
+		for(int k = 0 ; k < 256 ; k++){
+			float position=k*(size-1)/255.0f;
+			cell[k]=std::min((int)position, size-2);
+			fraction[k]=position-cell[k];
+		}
+	}
+
+	//Function interpolates the table at a cell with tetrahedral interpolation. The cell is split
+	//into six tetrahedra along its diagonal, the one holding the point is picked by the order of
+	//the fractions and its four corners are blended
+	Vec3f interpolate(int r, int g, int b, float fr, float fg, float fb) const{
+		const int sr=size*size;
+		const int sg=size;
+		const int sb=1;
+		int a,c;
+		float f1,f2,f3;
+
+		if(fr>=fg){
+			if(fg>=fb){ a=sr; c=sr+sg; f1=fr; f2=fg; f3=fb; }
+			else if(fr>=fb){ a=sr; c=sr+sb; f1=fr; f2=fb; f3=fg; }
+			else{ a=sb; c=sb+sr; f1=fb; f2=fr; f3=fg; }
+		}else{
+			if(fb>=fg){ a=sb; c=sb+sg; f1=fb; f2=fg; f3=fr; }
+			else if(fb>=fr){ a=sg; c=sg+sb; f1=fg; f2=fb; f3=fr; }
+			else{ a=sg; c=sg+sr; f1=fg; f2=fr; f3=fb; }
+		}
+
+		const Vec3f* node=&nodes[(r*size+g)*size+b];
+		const Vec3f& c0=node[0];
+		const Vec3f& cA=node[a];
+		const Vec3f& cC=node[c];
+		const Vec3f& c1=node[sr+sg+sb];
+		Vec3f color;
+		for(int k = 0 ; k < 3 ; k++){
+			color[k]=c0[k]+f1*(cA[k]-c0[k])+f2*(cC[k]-cA[k])+f3*(c1[k]-cC[k]);
+		}
+		return color;
+	}
+
+	//Function converts a single non-linear scaled [0-255] byte RGB pixel through the table,
+	//results are truncated as nRGBtonsRGBPixel does
+	Vec3b apply(const Vec3b& nsRGBval) const{
+		Vec3f value=interpolate(cell[nsRGBval[0]], cell[nsRGBval[1]], cell[nsRGBval[2]],
+		                        fraction[nsRGBval[0]], fraction[nsRGBval[1]], fraction[nsRGBval[2]]);
+		Vec3b color;
+		for(int k = 0 ; k < 3 ; k++) color[k]=(uchar)std::min(std::max((int)value[k], 0), 255);
+		return color;
+	}
+
+	//Function returns the error in 8 bit levels that 99 percent of a fixed set of random colors
+	//stay within, between the table and the exact conversion
+	template<typename Remap>
+	double error(const Remap& remap) const{
+		RNG rng(0x5eed);
+		vector<Vec3f> exact(checks);
+
+		for(int i = 0 ; i < checks ; i++){
+			exact[i]=Vec3f(rng.uniform(0.0f, 1.0f), rng.uniform(0.0f, 1.0f), rng.uniform(0.0f, 1.0f));
+		}
+		vector<Vec3f> points=exact;
+		remapChain(remap, exact);
+
+		vector<float> errors(checks);
+		for(int i = 0 ; i < checks ; i++){
+			int index[3];
+			float frac[3];
+			for(int k = 0 ; k < 3 ; k++){
+				float position=points[i][k]*(size-1);
+				index[k]=std::min((int)position, size-2);
+				frac[k]=position-index[k];
+			}
+			Vec3f value=interpolate(index[0], index[1], index[2], frac[0], frac[1], frac[2]);
+			float worst=0.0f;
+			for(int k = 0 ; k < 3 ; k++) worst=std::max(worst, fabsf(value[k]-exact[i][k]));
+			errors[i]=worst;
+		}
+
+		vector<float>::iterator percentile=errors.begin()+checks*99/100;
+		nth_element(errors.begin(), percentile, errors.end());
+		return *percentile;
+	}
+};
+
+//Function returns true when a size^3 table takes at most a quarter of the work of converting
+//every pixel of an image. Lattice points cost about twice as much as pixels
+static bool lutFits(int size, const Mat& image){
+	return 8.0*((double)size*size*size+RemapLUT::checks) <= (double)image.rows*image.cols;
+}
+
+//Function converts a non-linear scaled [0-255] byte RGB image through Luv with an L remap and back.
+//The conversion is sampled on a 33^3 lattice, then 65^3 and 129^3, until the table meets the error
+//bound, and the image goes through the table in one pass. Interpolation error falls about four times
+//each time the lattice spacing halves, so a larger lattice is only tried when that would meet the bound.
+//Images, and conversions such as the steps of histogram equalization, that no table fits are converted directly
+template<typename Remap>
+static void remapThroughLUT(const Mat& nsRGB, Mat& output, const Remap& remap){
+	for(int size = 33 ; size <= 129 && lutFits(size, nsRGB) ; size = 2*size-1){
+		RemapLUT lut(size, remap);
+		double error=lut.error(remap);
+
+		if(error<=lutErrorBound){
+			convertPixels<Vec3b,Vec3b>(nsRGB, output, [&lut](const Vec3b& pixel){ return lut.apply(pixel); });
+			return void();
+		}
+		if(error>4.0*lutErrorBound) break;
+	}
+
+	Mat Luv;
+	nsRGBtoLuv(nsRGB, Luv);
+	convertPixels<Vec3f,Vec3f>(Luv, Luv, [&remap](const Vec3f& pixel){
+		return Vec3f(remap(pixel[0]), pixel[1], pixel[2]);
+	}, Luv.type());
+	LuvtonsRGB(Luv, output);
+return void();
+}
+
+//Function takes non-linear scaled [0-255] byte RGB Mat object reference and window coordinates
+//(w1,w2,h1,h2) and updates stretchRGB Mat object reference with the image after linearly stretching
+//[0-100] L in the Luv domain, through a per-image 3D lookup table. Only the window is converted
+//to Luv to find the stretch values
+void WindowStretchLuvLUT(const Mat& nsRGB, Mat& stretchRGB, double w1, double w2, double h1, double h2){
+	double min=0.0;
+	double max=0.0;
+
+	if(nsRGB.type()!=CV_8UC3){
+		cout << "WARNING: Input nsRGB image type is not CV_8UC3." << endl;
+		return void();
+	}
+
+	//Images too small for a table are converted directly
+	if(!lutFits(33, nsRGB)){
+		Mat Luv;
+		nsRGBtoLuv(nsRGB, Luv);
+		WindowStretchLuv(Luv, Luv, w1, w2, h1, h2);
+		LuvtonsRGB(Luv, stretchRGB);
+		return void();
+	}
+
+	Rect window=windowRect(nsRGB.size(), w1, w2, h1, h2, 0);
+	if(window.area()>0){
+		Mat Luv;
+		nsRGBtoLuv(nsRGB(window), Luv);
+		windowMinMax(Luv, 0, Rect(0, 0, Luv.cols, Luv.rows), &min, &max);
+	}
+
+	remapThroughLUT(nsRGB, stretchRGB, [min,max](float L){ return stretchValue(L, min, max, 100.0); });
+return void();
+}
+
+//Function takes non-linear scaled [0-255] byte RGB Mat object reference and window coordinates
+//(w1,w2,h1,h2) and updates equRGB Mat object reference with the image after histogram equalizing
+//[0-100] L in the Luv domain, through a per-image 3D lookup table when one meets the error bound
+void LequLuvLUT(const Mat& nsRGB, Mat& equRGB, double w1, double w2, double h1, double h2){
+	int pix_map[101];
+
+	if(nsRGB.type()!=CV_8UC3){
+		cout << "WARNING: Input nsRGB image type is not CV_8UC3." << endl;
+		return void();
+	}
+
+	//Images too small for a table are converted directly
+	Mat Luv;
+	if(!lutFits(33, nsRGB)){
+		nsRGBtoLuv(nsRGB, Luv);
+		LequLuv(Luv, Luv, w1, w2, h1, h2);
+		LuvtonsRGB(Luv, equRGB);
+		return void();
+	}
+
+	//Size of the box is coordinates +1
+	nsRGBtoLuv(nsRGB(windowRect(nsRGB.size(), w1, w2, h1, h2, 1)), Luv);
+	equalizationMap(Luv, 0, Rect(0, 0, Luv.cols, Luv.rows), pix_map);
+
+	remapThroughLUT(nsRGB, equRGB, [&pix_map](float L){ return equalizeValue(pix_map, L); });
+return void();
+}
+
+//Conversion graph. Declared stages are planned into steps between a load and a store, and the steps
+//run one after the other over blocks of blockSize pixels held in a small buffer
+
+//Kind of a planned step
+enum GraphStepKind {swapStep, scaleStep, quantizeStep, invgammaStep, gammaStep, toXYZStep, fromXYZStep,
+	toxyYStep, fromxyYStep, toLuvStep, fromLuvStep, stretchStep, equalizeStep};
+
+//Planned step. Matrix steps carry their coefficients so R and B swaps can be folded into them,
+//window steps carry their window and, once the statistics are taken, their remap
+struct GraphStep {
+	GraphStepKind kind;
+	string name;
+	double m[9];
+	bool clampOne;
+	int channel;
+	double scale;
+	double w1, w2, h1, h2;
+	double min, max;
+	int pix_map[101];
+};
+
+//Planned graph, the steps between an 8 bit or float load and store. 8 bit loads and stores swap
+//R and B for free and replace invgamma and gamma steps at either end with their lookup tables
+struct GraphKernel {
+	bool loadBytes, loadSwap, loadTable;
+	bool storeBytes, storeSwap, storeTable;
+	vector<GraphStep> steps;
+};
+
+//Function returns the name of a color space
+static const char* spaceName(ColorSpace space){
+	static const char* names[]={"nsBGR", "nsRGB", "nRGB", "lRGB", "XYZ", "xyY", "Luv"};
+	return names[space];
+}
+
+//Function returns true for the 8 bit color spaces
+static bool isByteSpace(ColorSpace space){
+	return space==SPACE_nsBGR || space==SPACE_nsRGB;
+}
+
+//Function returns a step of the given kind, matrix steps get the matrix of their conversion
+static GraphStep graphStep(GraphStepKind kind){
+	static const char* names[]={"swap R and B", "scale to [0-1]", "quantize to [0-255]", "invgamma", "gamma",
+		"lRGB to XYZ matrix", "XYZ to lRGB matrix", "XYZ to xyY", "xyY to XYZ", "XYZ to Luv", "Luv to XYZ",
+		"window stretch", "equalize L"};
+	GraphStep step;
+
+	step.kind=kind;
+	step.name=names[kind];
+	for(int k = 0 ; k < 9 ; k++) step.m[k]=0.0;
+	if(kind==toXYZStep) memcpy(step.m, lRGBtoXYZMatrix, sizeof(step.m));
+	if(kind==fromXYZStep) memcpy(step.m, XYZtolRGBMatrix, sizeof(step.m));
+	step.clampOne=kind==fromXYZStep;
+	step.channel=0;
+	step.scale=0.0;
+	step.w1=step.w2=step.h1=step.h2=0.0;
+	step.min=step.max=0.0;
+	for(int k = 0 ; k < 101 ; k++) step.pix_map[k]=0;
+	return step;
+}
+
+//Function returns the space one conversion closer to XYZ, which all conversions pass through,
+//with the step that converts there and the step that converts back
+static ColorSpace parentSpace(ColorSpace space, GraphStepKind* up, GraphStepKind* down){
+	switch(space){
+	case SPACE_nsBGR: *up=swapStep; *down=swapStep; return SPACE_nsRGB;
+	case SPACE_nsRGB: *up=scaleStep; *down=quantizeStep; return SPACE_nRGB;
+	case SPACE_nRGB: *up=invgammaStep; *down=gammaStep; return SPACE_lRGB;
+	case SPACE_lRGB: *up=toXYZStep; *down=fromXYZStep; return SPACE_XYZ;
+	case SPACE_xyY: *up=fromxyYStep; *down=toxyYStep; return SPACE_XYZ;
+	case SPACE_Luv: *up=fromLuvStep; *down=toLuvStep; return SPACE_XYZ;
+	default:
+		//XYZ is the root of the tree, the callers stop there and never walk past it
+		*up=toXYZStep;
+		*down=fromXYZStep;
+		return SPACE_XYZ;
+	}
+}
+
+//Function returns the number of conversions between a space and XYZ
+static int spaceDepth(ColorSpace space){
+	GraphStepKind up, down;
+	int depth=0;
+
+	for( ; space!=SPACE_XYZ ; depth++) space=parentSpace(space, &up, &down);
+	return depth;
+}
+
+//Function appends the steps of the shortest conversion between two spaces
+static void appendConversion(ColorSpace from, ColorSpace to, vector<GraphStep>& steps){
+	GraphStepKind up, down;
+	vector<GraphStepKind> downSteps;
+	int fromDepth=spaceDepth(from);
+	int toDepth=spaceDepth(to);
+
+	//Walk both ends towards XYZ until they meet, the far end is walked back afterwards
+	while(from!=to){
+		if(fromDepth>=toDepth){
+			from=parentSpace(from, &up, &down);
+			fromDepth--;
+			steps.push_back(graphStep(up));
+		}else{
+			to=parentSpace(to, &up, &down);
+			toDepth--;
+			downSteps.push_back(down);
+		}
+	}
+	for(int k = (int)downSteps.size()-1 ; k >= 0 ; k--) steps.push_back(graphStep(downSteps[k]));
+return void();
+}
+
+//Function returns true when step b undoes step a. Going to 8 bit and back is not undone,
+//it quantizes, and neither is XYZ to lRGB and back, which clips to the RGB gamut
+static bool cancels(const GraphStep& a, const GraphStep& b){
+	switch(a.kind){
+	case swapStep: return b.kind==swapStep;
+	case scaleStep: return b.kind==quantizeStep;
+	case invgammaStep: return b.kind==gammaStep;
+	case gammaStep: return b.kind==invgammaStep;
+	case toXYZStep: return b.kind==fromXYZStep;
+	case toxyYStep: return b.kind==fromxyYStep;
+	case fromxyYStep: return b.kind==toxyYStep;
+	case toLuvStep: return b.kind==fromLuvStep;
+	case fromLuvStep: return b.kind==toLuvStep;
+	default: return false;
+	}
+}
+
+//Function returns true for steps that treat all three channels alike, which R and B swaps pass through
+static bool isUniformStep(const GraphStep& step){
+	return step.kind==scaleStep || step.kind==quantizeStep || step.kind==invgammaStep || step.kind==gammaStep;
+}
+
+//Function returns true for matrix steps
+static bool isMatrixStep(const GraphStep& step){
+	return step.kind==toXYZStep || step.kind==fromXYZStep;
+}
+
+//Function removes the R and B swaps of a kernel. A swap is moved past steps that treat the channels
+//alike and folded into the first matrix it meets, or into the 8 bit load or store
+static void foldSwaps(GraphKernel& kernel){
+	vector<GraphStep>& steps=kernel.steps;
+
+	for(size_t i = 0 ; i < steps.size() ; ){
+		if(steps[i].kind!=swapStep){
+			i++;
+			continue;
+		}
+
+		size_t after=i+1;
+		while(after<steps.size() && isUniformStep(steps[after])) after++;
+		int before=(int)i-1;
+		while(before>=0 && isUniformStep(steps[before])) before--;
+
+		if(after<steps.size() && isMatrixStep(steps[after])){
+			//Swapping the inputs of a matrix swaps its first and last columns
+			for(int r = 0 ; r < 3 ; r++) std::swap(steps[after].m[3*r], steps[after].m[3*r+2]);
+			steps[after].name+=" with R and B swapped";
+		}else if(before>=0 && isMatrixStep(steps[before])){
+			//Swapping the outputs of a matrix swaps its first and last rows
+			for(int c = 0 ; c < 3 ; c++) std::swap(steps[before].m[c], steps[before].m[6+c]);
+			steps[before].name+=" with R and B swapped";
+		}else if(before<0){
+			kernel.loadSwap=!kernel.loadSwap;
+		}else if(after==steps.size()){
+			kernel.storeSwap=!kernel.storeSwap;
+		}else{
+			i++;
+			continue;
+		}
+		steps.erase(steps.begin()+i);
+	}
+return void();
+}
+
+//Function plans a conversion graph into a kernel. Window statistics are left to takeWindowStatistics
+static GraphKernel planGraph(const ConversionGraph& graph){
+	GraphKernel kernel;
+	vector<GraphStep> declared;
+	ColorSpace space=graph.input;
+
+	for(size_t k = 0 ; k < graph.stages.size() ; k++){
+		const ConversionGraph::Stage& stage=graph.stages[k];
+		if(stage.kind==ConversionGraph::convertStage){
+			appendConversion(space, stage.space, declared);
+			space=stage.space;
+			continue;
+		}
+
+		GraphStep step=graphStep(stage.kind==ConversionGraph::windowStretchStage ? stretchStep : equalizeStep);
+		if(stage.kind==ConversionGraph::windowStretchStage){
+			step.channel=space==SPACE_xyY ? 2 : 0;
+			step.scale=space==SPACE_xyY ? 1.0 : 100.0;
+			step.name+=space==SPACE_xyY ? " of Y" : " of L";
+		}
+		step.w1=stage.w1;
+		step.w2=stage.w2;
+		step.h1=stage.h1;
+		step.h2=stage.h2;
+		declared.push_back(step);
+	}
+
+	//Drop round trips, a step that undoes the one before removes both
+	for(size_t k = 0 ; k < declared.size() ; k++){
+		if(!kernel.steps.empty() && cancels(kernel.steps.back(), declared[k])) kernel.steps.pop_back();
+		else kernel.steps.push_back(declared[k]);
+	}
+
+	kernel.loadBytes=isByteSpace(graph.input);
+	kernel.storeBytes=isByteSpace(graph.output);
+	kernel.loadSwap=false;
+	kernel.storeSwap=false;
+	foldSwaps(kernel);
+
+	//An 8 bit load followed by invgamma reads the invgamma table, gamma followed by an 8 bit store
+	//uses the gamma thresholds, both as the single pass conversions do
+	vector<GraphStep>& steps=kernel.steps;
+	kernel.loadTable=kernel.loadBytes && steps.size()>=2 && steps[0].kind==scaleStep && steps[1].kind==invgammaStep;
+	if(kernel.loadTable) steps.erase(steps.begin(), steps.begin()+2);
+	kernel.storeTable=kernel.storeBytes && steps.size()>=2 && steps[steps.size()-2].kind==gammaStep && steps.back().kind==quantizeStep;
+	if(kernel.storeTable) steps.erase(steps.end()-2, steps.end());
+	return kernel;
+}
+
+//Function applies a planned step to a block of pixels in place
+static void applyGraphStep(const GraphStep& step, bool fast, MatrixRowFunc matrix, Vec3f* pixels, int count){
+	float* values=pixels->val;
+
+	switch(step.kind){
+	case swapStep:
+		for(int i = 0 ; i < count ; i++) std::swap(pixels[i][0], pixels[i][2]);
+		break;
+	case scaleStep:
+		for(int i = 0 ; i < 3*count ; i++) values[i]=values[i]/255.0;
+		break;
+	case quantizeStep:
+		//Truncates like nRGBtonsRGBPixel, the value stays a float until the store
+		for(int i = 0 ; i < 3*count ; i++){
+			float value=255*values[i];
+			if(value<0.0) value=0.0;
+			if(value>255.0) value=255.0;
+			values[i]=(float)(int)value;
+		}
+		break;
+	case invgammaStep:
+		if(fast) curveRow<fastInvgamma>(pixels, pixels, count);
+		else curveRow<invgamma>(pixels, pixels, count);
+		break;
+	case gammaStep:
+		if(fast) curveRow<fastGamma>(pixels, pixels, count);
+		else curveRow<gamma>(pixels, pixels, count);
+		break;
+	case toXYZStep:
+	case fromXYZStep:
+		matrix(step.m, step.clampOne, pixels, pixels, count);
+		break;
+	case toxyYStep:
+		XYZtoxyYBlock(pixels, count);
+		break;
+	case fromxyYStep:
+		for(int i = 0 ; i < count ; i++) pixels[i]=xyYtoXYZPixel(pixels[i]);
+		break;
+	case toLuvStep:
+		XYZtoLuvBlock(fast, pixels, count);
+		break;
+	case fromLuvStep:
+		for(int i = 0 ; i < count ; i++) pixels[i]=LuvtoXYZPixel(pixels[i]);
+		break;
+	case stretchStep:
+		for(int i = 0 ; i < count ; i++) pixels[i][step.channel]=stretchValue(pixels[i][step.channel], step.min, step.max, step.scale);
+		break;
+	case equalizeStep:
+		for(int i = 0 ; i < count ; i++) pixels[i][0]=equalizeValue(step.pix_map, pixels[i][0]);
+		break;
+	}
+return void();
+}
+
+//Function loads a block of 8 bit pixels, through the invgamma table when the kernel starts with it
+static inline void loadGraphBlock(const GraphKernel& kernel, const float* table, const Vec3b* input, Vec3f* pixels, int count){
+	for(int i = 0 ; i < count ; i++){
+		Vec3f color=kernel.loadTable ? nsRGBtolRGBPixel(table, input[i]) : Vec3f(input[i][0], input[i][1], input[i][2]);
+		if(kernel.loadSwap) std::swap(color[0], color[2]);
+		pixels[i]=color;
+	}
+}
+
+//Function loads a block of float pixels, the invgamma table only applies to 8 bit pixels
+static inline void loadGraphBlock(const GraphKernel& kernel, const float*, const Vec3f* input, Vec3f* pixels, int count){
+	for(int i = 0 ; i < count ; i++){
+		pixels[i]=input[i];
+		if(kernel.loadSwap) std::swap(pixels[i][0], pixels[i][2]);
+	}
+}
+
+//Function stores a block of 8 bit pixels, through the gamma thresholds when the kernel ends with them
+static inline void storeGraphBlock(const GraphKernel& kernel, const float* thresholds, const Vec3f* pixels, Vec3b* output, int count){
+	for(int i = 0 ; i < count ; i++){
+		Vec3b color=kernel.storeTable ? lRGBtonsRGBPixel(thresholds, pixels[i]) : Vec3b((uchar)pixels[i][0], (uchar)pixels[i][1], (uchar)pixels[i][2]);
+		if(kernel.storeSwap) std::swap(color[0], color[2]);
+		output[i]=color;
+	}
+}
+
+//Function stores a block of float pixels, the gamma thresholds only apply to 8 bit pixels
+static inline void storeGraphBlock(const GraphKernel& kernel, const float*, const Vec3f* pixels, Vec3f* output, int count){
+	for(int i = 0 ; i < count ; i++){
+		output[i]=pixels[i];
+		if(kernel.storeSwap) std::swap(output[i][0], output[i][2]);
+	}
+}
+
+//Function runs a kernel over every row of the input image in blocks
+template<typename Tin, typename Tout>
+static void runGraphRows(const GraphKernel& kernel, const Mat& input, Mat& output, int type){
+	const float* table=invgammaTable();
+	const float* thresholds=gammaThresholds();
+	MatrixRowFunc matrix=matrixRow();
+	bool fast=useFastMath();
+
+	convertRows<Tin,Tout>(input, output, [&kernel,table,thresholds,matrix,fast](const Tin* inputRow, Tout* outputRow, int n){
+		Vec3f pixels[blockSize];
+
+		for(int start = 0 ; start < n ; start += blockSize){
+			int count = std::min(blockSize, n-start);
+
+			loadGraphBlock(kernel, table, inputRow+start, pixels, count);
+			for(size_t s = 0 ; s < kernel.steps.size() ; s++) applyGraphStep(kernel.steps[s], fast, matrix, pixels, count);
+			storeGraphBlock(kernel, thresholds, pixels, outputRow+start, count);
+		}
+	}, type);
+}
+
+//Function runs a kernel from the input image to the output image, float output is stored with the given depth
+static void runGraphKernel(const GraphKernel& kernel, const Mat& input, Mat& output, int floatDepth){
+	if(kernel.loadBytes && kernel.storeBytes) runGraphRows<Vec3b,Vec3b>(kernel, input, output, CV_8UC3);
+	else if(kernel.loadBytes) runGraphRows<Vec3b,Vec3f>(kernel, input, output, CV_MAKETYPE(floatDepth,3));
+	else if(kernel.storeBytes) runGraphRows<Vec3f,Vec3b>(kernel, input, output, CV_8UC3);
+	else runGraphRows<Vec3f,Vec3f>(kernel, input, output, CV_MAKETYPE(floatDepth,3));
+return void();
+}
+
+//Function returns true for the steps that need window statistics
+static bool isWindowStep(const GraphStep& step){
+	return step.kind==stretchStep || step.kind==equalizeStep;
+}
+
+//Rows per band when the window statistics of an image held in memory are taken
+static const int statisticsBandRows=128;
+
+//Function takes the statistics of every window step. The steps before it are run over the window
+//only, in bands of at most bandRows rows read with readRows(row, count, band), so no full size
+//intermediate image is made. Returns false when a band can't be read
+template<typename ReadRows>
+static bool takeWindowStatistics(GraphKernel& kernel, Size size, int bandRows, ReadRows readRows){
+	const float infinity=numeric_limits<float>::infinity();
+
+	for(size_t k = 0 ; k < kernel.steps.size() ; k++){
+		GraphStep& step=kernel.steps[k];
+		if(!isWindowStep(step)) continue;
+
+		GraphKernel prefix=kernel;
+		prefix.steps.resize(k);
+		prefix.storeBytes=false;
+		prefix.storeSwap=false;
+		prefix.storeTable=false;
+
+		//Size of the equalization box is coordinates +1, as in LequLuv
+		Rect window=windowRect(size, step.w1, step.w2, step.h1, step.h2, step.kind==equalizeStep ? 1 : 0);
+		double low=infinity;
+		double high=-infinity;
+		int hist[101];
+		for(int h = 0 ; h < 101 ; h++) hist[h] = 0;
+
+		Mat band, region;
+		for(int y = window.y ; y < window.y+window.height ; y += bandRows){
+			int count=std::min(bandRows, window.y+window.height-y);
+			if(!readRows(y, count, band)) return false;
+			runGraphKernel(prefix, band(Rect(window.x, 0, window.width, count)), region, CV_32F);
+
+			Rect all(0, 0, region.cols, region.rows);
+			if(step.kind==equalizeStep){
+				accumulateHistogram(region, 0, all, hist);
+				continue;
+			}
+			double min,max;
+			windowMinMax(region, step.channel, all, &min, &max);
+			if(region.cols>0){
+				if(min<low) low=min;
+				if(max>high) high=max;
+			}
+		}
+
+		if(step.kind==equalizeStep){
+			equalizationMapFromHistogram(hist, window.width*window.height, step.pix_map);
+			continue;
+		}
+		//An empty window gives 0 for both, as windowMinMax does
+		if(low>high){
+			low=0.0;
+			high=0.0;
+		}
+		step.min=low;
+		step.max=high;
+	}
+	return true;
+}
+
+//Function describes the first steps of a kernel, with its store or with a float store
+static string describeKernel(const GraphKernel& kernel, size_t steps, bool store){
+	string text=kernel.loadBytes ? "load bytes" : "load floats";
+	if(kernel.loadSwap) text+=" with R and B swapped";
+	if(kernel.loadTable) text+=" through the invgamma table";
+
+	for(size_t s = 0 ; s < steps ; s++) text+=", "+kernel.steps[s].name;
+
+	if(!store) return text+", store floats";
+	text+=kernel.storeBytes ? ", store bytes" : ", store floats";
+	if(kernel.storeTable) text+=" through the gamma thresholds";
+	if(kernel.storeSwap) text+=" with R and B swapped";
+	return text;
+}
+
+//Function starts a graph whose input images are in the given space
+ConversionGraph::ConversionGraph(ColorSpace space){
+	input=space;
+	output=space;
+}
+
+//Function appends a conversion to the given space
+ConversionGraph& ConversionGraph::to(ColorSpace space){
+	Stage stage={convertStage, space, 0.0, 0.0, 0.0, 0.0};
+
+	stages.push_back(stage);
+	output=space;
+	return *this;
+}
+
+//Function appends a window stretch of L in Luv or of Y in xyY based on window {h1,w1},{h2,w2}
+ConversionGraph& ConversionGraph::windowStretch(double w1, double w2, double h1, double h2){
+	if(output!=SPACE_Luv && output!=SPACE_xyY){
+		cout << "WARNING: Window stretch needs a Luv or xyY image, not " << spaceName(output) << "." << endl;
+		return *this;
+	}
+	Stage stage={windowStretchStage, output, w1, w2, h1, h2};
+
+	stages.push_back(stage);
+	return *this;
+}
+
+//Function appends a histogram equalization of L in Luv based on window {h1,w1},{h2,w2}
+ConversionGraph& ConversionGraph::equalize(double w1, double w2, double h1, double h2){
+	if(output!=SPACE_Luv){
+		cout << "WARNING: Equalization needs a Luv image, not " << spaceName(output) << "." << endl;
+		return *this;
+	}
+	Stage stage={equalizeStage, output, w1, w2, h1, h2};
+
+	stages.push_back(stage);
+	return *this;
+}
+
+//Function returns a description of the planned passes, one line per pass
+string ConversionGraph::plan() const{
+	GraphKernel kernel=planGraph(*this);
+	string text;
+
+	for(size_t k = 0 ; k < kernel.steps.size() ; k++){
+		if(isWindowStep(kernel.steps[k])) text+="window pass: "+describeKernel(kernel, k, false)+"\n";
+	}
+	text+="image pass: "+describeKernel(kernel, kernel.steps.size(), true)+"\n";
+	return text;
+}
+
+//Function runs the graph from an input image to an output image, which may be the same Mat.
+//8 bit output is CV_8UC3, float output is created with the intermediate depth
+void ConversionGraph::run(const Mat& inputImage, Mat& outputImage) const{
+	if(isByteSpace(input) && inputImage.type()!=CV_8UC3){
+		cout << "WARNING: Input " << spaceName(input) << " image type is not CV_8UC3." << endl;
+		return void();
+	}
+	if(!isByteSpace(input) && !isFloatImage(inputImage)){
+		cout << "WARNING: Input " << spaceName(input) << " image type is not CV_32FC3 or CV_16FC3." << endl;
+		return void();
+	}
+
+	//The window rows of the input are read as views of statisticsBandRows rows, so the steps before a
+	//window step only ever hold one band of intermediate pixels
+	GraphKernel kernel=planGraph(*this);
+	takeWindowStatistics(kernel, inputImage.size(), statisticsBandRows, [&inputImage](int row, int count, Mat& band){
+		band=inputImage.rowRange(row, row+count);
+		return true;
+	});
+	runGraphKernel(kernel, inputImage, outputImage, intermediateDepth);
+return void();
+}
+
+//Function runs the graph over an image read from a band source and written to a band sink, bandRows
+//rows at a time. A first pass reads only the rows the windows cover, a second pass converts and writes
+//every band, so memory depends on the band size and not on the image size. Returns false when a band
+//can't be read or written
+bool ConversionGraph::stream(BandSource& source, BandSink& sink, int bandRows) const{
+	int rows=source.rows();
+	int cols=source.cols();
+	int type=source.type();
+	int outputType=isByteSpace(output) ? CV_8UC3 : CV_MAKETYPE(intermediateDepth,3);
+	bandRows=std::max(bandRows, 1);
+
+	if(isByteSpace(input) && type!=CV_8UC3){
+		cout << "WARNING: Input " << spaceName(input) << " band source type is not CV_8UC3." << endl;
+		return false;
+	}
+	if(!isByteSpace(input) && type!=CV_32FC3 && type!=CV_16FC3){
+		cout << "WARNING: Input " << spaceName(input) << " band source type is not CV_32FC3 or CV_16FC3." << endl;
+		return false;
+	}
+
+	GraphKernel kernel=planGraph(*this);
+	if(!takeWindowStatistics(kernel, Size(cols, rows), bandRows, [&source](int row, int count, Mat& band){
+		return source.read(row, count, band);
+	})) return false;
+
+	//Bands that keep their type are converted in place, so one band buffer is all that is held
+	if(!sink.begin(rows, cols, outputType)) return false;
+	Mat band, converted;
+	for(int row = 0 ; row < rows ; row += bandRows){
+		int count=std::min(bandRows, rows-row);
+		if(!source.read(row, count, band)) return false;
+
+		Mat& result=band.type()==outputType ? band : converted;
+		runGraphKernel(kernel, band, result, intermediateDepth);
+		if(!sink.write(result)) return false;
+	}
+	return sink.end();
+}
+
+//Function reads the next number of a PPM header, skipping white space and comments.
+//The single white space character after the number is consumed with it
+static bool readPPMNumber(istream& file, int* value){
+	int c=file.get();
+
+	while(file && (isspace(c) || c=='#')){
+		if(c=='#'){
+			while(file && c!='\n') c=file.get();
+		}
+		c=file.get();
+	}
+	if(!file || !isdigit(c)) return false;
+
+	long number=0;
+	while(file && isdigit(c) && number<=numeric_limits<int>::max()){
+		number=number*10+(c-'0');
+		c=file.get();
+	}
+	if(number>numeric_limits<int>::max()) return false;
+	*value=(int)number;
+	return true;
+}
+
+//Function copies an image held in memory, bands are copied out of it
+MatBandSource::MatBandSource(const Mat& source){
+	image=source;
+}
+
+//Function returns the number of rows of the image
+int MatBandSource::rows() const{
+	return image.rows;
+}
+
+//Function returns the number of columns of the image
+int MatBandSource::cols() const{
+	return image.cols;
+}
+
+//Function returns the type of the image
+int MatBandSource::type() const{
+	return image.type();
+}
+
+//Function copies count rows starting at row into band
+bool MatBandSource::read(int row, int count, Mat& band){
+	if(row<0 || count<0 || row+count>image.rows) return false;
+	image.rowRange(row, row+count).copyTo(band);
+	return true;
+}
+
+//Function allocates the image the bands are written to
+bool MatBandSink::begin(int rows, int cols, int type){
+	image.create(rows, cols, type);
+	row=0;
+	return true;
+}
+
+//Function copies a band of rows below the rows written so far
+bool MatBandSink::write(const Mat& band){
+	if(band.type()!=image.type() || band.cols!=image.cols || row+band.rows>image.rows) return false;
+	Mat rows=image.rowRange(row, row+band.rows);
+	band.copyTo(rows);
+	row+=band.rows;
+	return true;
+}
+
+//Function returns true when every row was written
+bool MatBandSink::end(){
+	return row==image.rows;
+}
+
+//Function reads the header of a binary PPM (P6) or PGM (P5) file and returns the number of channels,
+//or 0 when the file is not one. The stream is left at the first pixel
+static int readNetpbmHeader(istream& file, int* width, int* height, int* maxval){
+	char magic[2]={0,0};
+
+	file.read(magic, 2);
+	if(!file || magic[0]!='P' || (magic[1]!='6' && magic[1]!='5')) return 0;
+	if(!readPPMNumber(file, width) || !readPPMNumber(file, height) || !readPPMNumber(file, maxval)) return 0;
+	if(*width<=0 || *height<=0 || *maxval<=0 || *maxval>65535) return 0;
+	return magic[1]=='6' ? 3 : 1;
+}
+
+//Function opens a binary 8 bit PPM or PGM file and reads its header, a file that can't be read
+//is reported and gives an empty source
+PPMBandSource::PPMBandSource(const string& path) : file(path.c_str(), ios::binary), width(0), height(0), channels(0), data(0){
+	int maxval=0;
+
+	channels=readNetpbmHeader(file, &width, &height, &maxval);
+	if(channels==0 || maxval!=255){
+		cout << "WARNING: Could not read " << path << " as a binary 8 bit PPM or PGM image." << endl;
+		file.close();
+		width=0;
+		height=0;
+		channels=0;
+		return;
+	}
+	data=file.tellg();
+}
+
+//Function returns true when the header was read
+bool PPMBandSource::isOpen() const{
+	return file.is_open();
+}
+
+//Function returns the number of rows of the image
+int PPMBandSource::rows() const{
+	return height;
+}
+
+//Function returns the number of columns of the image
+int PPMBandSource::cols() const{
+	return width;
+}
+
+//Function returns the type of the image, PPM rows are nsRGB bytes and PGM rows gray bytes
+int PPMBandSource::type() const{
+	return CV_MAKETYPE(CV_8U, std::max(channels, 1));
+}
+
+//Function reads count rows starting at row into band
+bool PPMBandSource::read(int row, int count, Mat& band){
+	if(!file.is_open() || row<0 || count<0 || row+count>height) return false;
+
+	band.create(count, width, type());
+	file.clear();
+	file.seekg(data+(streamoff)row*width*channels);
+	for(int j = 0 ; j < count ; j++) file.read((char*)band.ptr(j), (streamsize)width*channels);
+	return !file.fail();
+}
+
+//Function keeps the path of the PPM or PGM file, it is created when the first band is about to be written
+PPMBandSink::PPMBandSink(const string& path) : path(path), width(0), height(0), channels(0), written(0){
+}
+
+//Function creates the file and writes the header, PPM for CV_8UC3 bands and PGM for CV_8UC1 bands
+bool PPMBandSink::begin(int rows, int cols, int type){
+	if(type!=CV_8UC3 && type!=CV_8UC1){
+		cout << "WARNING: PPM band sink needs CV_8UC3 or CV_8UC1 bands." << endl;
+		return false;
+	}
+	channels=CV_MAT_CN(type);
+	file.open(path.c_str(), ios::binary);
+	file << (channels==3 ? "P6\n" : "P5\n") << cols << " " << rows << "\n255\n";
+	width=cols;
+	height=rows;
+	written=0;
+	if(!file){
+		cout << "WARNING: Could not write " << path << "." << endl;
+		return false;
+	}
+	return true;
+}
+
+//Function appends a band of rows to the file
+bool PPMBandSink::write(const Mat& band){
+	if(band.type()!=CV_MAKETYPE(CV_8U, channels) || band.cols!=width || written+band.rows>height) return false;
+
+	for(int j = 0 ; j < band.rows ; j++) file.write((const char*)band.ptr(j), (streamsize)width*channels);
+	written+=band.rows;
+	return !file.fail();
+}
+
+//Function closes the file, returns true when every row was written
+bool PPMBandSink::end(){
+	file.close();
+	if(file.fail() || written!=height){
+		cout << "WARNING: Could not write " << path << "." << endl;
+		return false;
+	}
+	return true;
+}
+
+//Function streams a non-linear scaled [0-255] RGB image through nsRGB to Luv, the window stretch of L
+//and Luv to nsRGB, bandRows rows at a time
+bool WindowStretchLuvStream(BandSource& nsRGB, BandSink& stretchRGB, double w1, double w2, double h1, double h2, int bandRows){
+	ConversionGraph graph(SPACE_nsRGB);
+
+	graph.to(SPACE_Luv).windowStretch(w1, w2, h1, h2).to(SPACE_nsRGB);
+	return graph.stream(nsRGB, stretchRGB, bandRows);
+}
+
+//Function streams a non-linear scaled [0-255] RGB image through nsRGB to Luv, the histogram
+//equalization of L and Luv to nsRGB, bandRows rows at a time
+bool LequLuvStream(BandSource& nsRGB, BandSink& equRGB, double w1, double w2, double h1, double h2, int bandRows){
+	ConversionGraph graph(SPACE_nsRGB);
+
+	graph.to(SPACE_Luv).equalize(w1, w2, h1, h2).to(SPACE_nsRGB);
+	return graph.stream(nsRGB, equRGB, bandRows);
+}
+
+//Function writes an 8 bit image to a binary PPM (CV_8UC3, rows in nsRGB order) or PGM (CV_8UC1) file.
+//Rows are written straight from the image one at a time, without encoding or copying it
+bool writeNetpbm(const string& path, const Mat& image){
+	PPMBandSink sink(path);
+
+	if(!sink.begin(image.rows, image.cols, image.type())) return false;
+	if(!sink.write(image)){
+		sink.end();
+		return false;
+	}
+	return sink.end();
+}
+
+//Function starts with no file mapped
+MappedImage::MappedImage() : mapping(0), bytes(0){
+}
+
+//Function unmaps the file
+MappedImage::~MappedImage(){
+	close();
+}
+
+//Function releases the image header and unmaps the file
+void MappedImage::close(){
+	image.release();
+#ifndef _WIN32
+	if(mapping) munmap(mapping, bytes);
+#endif
+	mapping=0;
+	bytes=0;
+}
+
+//Function maps a binary PPM or PGM file and wraps its pixels in image without copying them. The mapping
+//is private, so the image may be converted in place without changing the file, and pages are read from
+//the file when they are first touched. 16 bit files are stored big endian and are byte swapped in
+//the mapping, which touches every page. When the header leaves their pixels at an odd offset they
+//can't be wrapped as aligned 16 bit values, so they are swapped into an image of their own instead
+//and the file is unmapped. Returns false, with an empty image, when the file can't be mapped
+bool MappedImage::open(const string& path){
+	close();
+#ifdef _WIN32
+	cout << "WARNING: Mapped images are not supported on this platform." << endl;
+	return false;
+#else
+	int width=0, height=0, maxval=0;
+	ifstream header(path.c_str(), ios::binary);
+	int channels=readNetpbmHeader(header, &width, &height, &maxval);
+	streamoff data=header ? (streamoff)header.tellg() : 0;
+	header.close();
+	if(channels==0){
+		cout << "WARNING: Could not read " << path << " as a binary PPM or PGM image." << endl;
+		return false;
+	}
+
+	int depth=maxval>255 ? CV_16U : CV_8U;
+	size_t payload=(size_t)width*height*channels*(depth==CV_16U ? 2 : 1);
+	int fd=::open(path.c_str(), O_RDONLY);
+	struct stat info;
+	void* mapped=MAP_FAILED;
+	if(fd>=0 && fstat(fd, &info)==0 && (size_t)info.st_size>=(size_t)data+payload){
+		mapped=mmap(0, (size_t)info.st_size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0);
+	}
+	if(fd>=0) ::close(fd);
+	if(mapped==MAP_FAILED){
+		cout << "WARNING: Could not map " << path << "." << endl;
+		return false;
+	}
+
+	if(depth==CV_16U && data%2!=0){
+		image.create(height, width, CV_MAKETYPE(depth, channels));
+		const uchar* bytesIn=(const uchar*)mapped+data;
+		uchar* pixels=image.data;
+		for(size_t k = 0 ; k < payload ; k += 2){
+			pixels[k]=bytesIn[k+1];
+			pixels[k+1]=bytesIn[k];
+		}
+		munmap(mapped, (size_t)info.st_size);
+		return true;
+	}
+
+	mapping=mapped;
+	bytes=(size_t)info.st_size;
+	image=Mat(height, width, CV_MAKETYPE(depth, channels), (uchar*)mapping+data);
+
+	if(depth==CV_16U){
+		uchar* pixels=image.data;
+		for(size_t k = 0 ; k < payload ; k += 2) std::swap(pixels[k], pixels[k+1]);
+	}
+	return true;
+#endif
+}
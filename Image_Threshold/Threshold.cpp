@@ -27,6 +27,7 @@
 #include <opencv2/opencv.hpp>
 #include <opencv2/highgui.hpp>
 #include <iostream>
+#include "color_histogram.hpp"
 
 using namespace cv;
 using namespace std;
@@ -65,12 +66,10 @@ int main(int argc, char** argv) {
   }
   imshow("grayImage", grayImage);
 
-  // Compute the histogram
+  // Compute the histogram with the parallel histogram engine shared with the color conversions
   int hist[256];
   for(int k = 0 ; k < 256 ; k++) hist[k] = 0;
-  for(int i = 0 ; i < rows ; i++)
-    for(int j = 0 ; j < cols ; j++) 
-      hist[grayImage.at<uchar>(i,j)]++;
+  histogram8U(grayImage, 0, Rect(0, 0, cols, rows), hist);
 
   // Print the histogram
   for(int i=0 ; i<256 ; i++){